@@ -0,0 +1,80 @@
+#include "affinity.hpp"
+
+#include <sched.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+namespace File {
+
+std::vector<int> AllowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+
+    return cpus;
+}
+
+int CpuNode(int cpu) {
+    // The CPU's sysfs directory links to its node as "node<N>".
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR *directory = opendir(path.c_str());
+
+    if (directory == nullptr) {
+        return 0;
+    }
+
+    int node = 0;
+    struct dirent *entry;
+
+    while ((entry = readdir(directory)) != nullptr) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+
+    closedir(directory);
+
+    return node;
+}
+
+bool PinCurrentThread(int cpu) {
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+std::vector<int> CpusByNode() {
+    std::vector<int> cpus = AllowedCpus();
+    std::vector<std::pair<int, int>> nodes;
+
+    for (int cpu : cpus) {
+        nodes.push_back(std::make_pair(CpuNode(cpu), cpu));
+    }
+
+    std::sort(nodes.begin(), nodes.end());
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        cpus[i] = nodes[i].second;
+    }
+
+    return cpus;
+}
+
+} // End File
@@ -0,0 +1,27 @@
+#ifndef FILE_AFFINITY_H
+#define FILE_AFFINITY_H
+
+#include <vector>
+
+namespace File
+{
+
+// CPU and NUMA topology, for pinning parallel readers so that a range is read and
+// processed by the same core, into memory on that core's node.
+
+// The CPUs this process is allowed to run on, in ascending order.
+std::vector<int> AllowedCpus();
+
+// The NUMA node of a CPU, read from sysfs. 0 when the kernel doesn't say, as on
+// single node machines.
+int CpuNode(int cpu);
+
+// Pin the calling thread to a single CPU.
+bool PinCurrentThread(int cpu);
+
+// The allowed CPUs grouped by node, so that consecutive workers share a node.
+std::vector<int> CpusByNode();
+
+} // End File
+
+#endif // FILE_AFFINITY_H
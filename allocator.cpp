@@ -0,0 +1,251 @@
+#include "allocator.hpp"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace File {
+
+namespace {
+
+const size_t ALIGNMENT = 64;
+
+const size_t SMALLEST_CLASS = 12;
+const size_t LARGEST_CLASS = 26;
+const size_t CLASS_COUNT = LARGEST_CLASS - SMALLEST_CLASS + 1;
+const size_t MAX_CACHED_BYTES = 64 << 20;
+
+char * HeapAllocate(size_t size, size_t * capacity) {
+    void *memory = nullptr;
+
+    if (posix_memalign(&memory, ALIGNMENT, size > 0 ? size : 1) != 0) {
+        return nullptr;
+    }
+
+    *capacity = size;
+
+    return static_cast<char *>(memory);
+}
+
+void HeapFree(char * memory, size_t) {
+    free(memory);
+}
+
+// The smallest class holding size, or CLASS_COUNT if it's too big for any.
+size_t SizeClass(size_t size) {
+    size_t shift = SMALLEST_CLASS;
+
+    while (shift <= LARGEST_CLASS && (static_cast<size_t>(1) << shift) < size) {
+        shift++;
+    }
+
+    return shift - SMALLEST_CLASS;
+}
+
+// Set once the thread's cache is gone, for buffers freed by thread local objects destroyed
+// after it.
+thread_local bool cache_destroyed = false;
+
+struct ThreadCache
+{
+    std::vector<char *> free_lists[CLASS_COUNT];
+    size_t bytes = 0;
+
+    ~ThreadCache() {
+        cache_destroyed = true;
+        Clear();
+    }
+
+    void Clear() {
+        for (std::vector<char *> & list : free_lists) {
+            for (char * memory : list) {
+                free(memory);
+            }
+
+            list.clear();
+        }
+
+        bytes = 0;
+    }
+};
+
+ThreadCache * Cache() {
+    if (cache_destroyed) {
+        return nullptr;
+    }
+
+    static thread_local ThreadCache cache;
+
+    return &cache;
+}
+
+char * PooledAllocate(size_t size, size_t * capacity) {
+    size_t size_class = SizeClass(size);
+
+    if (size_class == CLASS_COUNT) {
+        return HeapAllocate(size, capacity);
+    }
+
+    ThreadCache *cache = Cache();
+
+    *capacity = static_cast<size_t>(1) << (size_class + SMALLEST_CLASS);
+
+    if (cache != nullptr && !cache->free_lists[size_class].empty()) {
+        char *memory = cache->free_lists[size_class].back();
+        cache->free_lists[size_class].pop_back();
+        cache->bytes -= *capacity;
+
+        return memory;
+    }
+
+    size_t ignored;
+
+    return HeapAllocate(*capacity, &ignored);
+}
+
+void PooledFree(char * memory, size_t capacity) {
+    if (memory == nullptr) {
+        return;
+    }
+
+    size_t size_class = SizeClass(capacity);
+    ThreadCache *cache = Cache();
+
+    // Only whole classes came from the pool, anything else was a large heap allocation.
+    if (cache == nullptr || size_class == CLASS_COUNT ||
+        (static_cast<size_t>(1) << (size_class + SMALLEST_CLASS)) != capacity ||
+        cache->bytes + capacity > MAX_CACHED_BYTES) {
+        free(memory);
+        return;
+    }
+
+    cache->free_lists[size_class].push_back(memory);
+    cache->bytes += capacity;
+}
+
+} // End anonymous namespace
+
+BufferAllocator::BufferAllocator(AllocateFunction allocate, FreeFunction free) :
+    allocate(allocate),
+    free(free)
+{}
+
+char * BufferAllocator::Allocate(size_t size, size_t * capacity) const {
+    return allocate(size, capacity);
+}
+
+void BufferAllocator::Free(char * memory, size_t capacity) const {
+    free(memory, capacity);
+}
+
+const BufferAllocator & BufferAllocator::Heap() {
+    static BufferAllocator heap(HeapAllocate, HeapFree);
+
+    return heap;
+}
+
+const BufferAllocator & BufferAllocator::Pooled() {
+    static BufferAllocator pooled(PooledAllocate, PooledFree);
+
+    return pooled;
+}
+
+void BufferAllocator::Trim() {
+    ThreadCache *cache = Cache();
+
+    if (cache != nullptr) {
+        cache->Clear();
+    }
+}
+
+size_t BufferAllocator::CachedBytes() {
+    ThreadCache *cache = Cache();
+
+    return cache != nullptr ? cache->bytes : 0;
+}
+
+Arena::Arena(size_t block_size, const BufferAllocator & allocator) :
+    allocator(allocator),
+    block_size(block_size > 0 ? block_size : 1),
+    current(0),
+    offset(0),
+    used(0)
+{}
+
+Arena::~Arena() {
+    for (Block & block : blocks) {
+        allocator.Free(block.data, block.capacity);
+    }
+}
+
+char * Arena::Allocate(size_t size, size_t alignment) {
+    while (current < blocks.size()) {
+        Block &block = blocks[current];
+        size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+
+        if (aligned + size <= block.capacity) {
+            offset = aligned + size;
+            used += size;
+
+            return block.data + aligned;
+        }
+
+        // Move on to the next block kept from before a reset, or make a new one.
+        current++;
+        offset = 0;
+    }
+
+    Block block;
+    block.data = allocator.Allocate(size > block_size ? size : block_size, &block.capacity);
+
+    if (block.data == nullptr) {
+        return nullptr;
+    }
+
+    blocks.push_back(block);
+    current = blocks.size() - 1;
+    offset = size;
+    used += size;
+
+    return block.data;
+}
+
+View Arena::Copy(const View & bytes) {
+    char *memory = Allocate(bytes.size(), 1);
+
+    if (memory == nullptr) {
+        return View();
+    }
+
+    memcpy(memory, bytes.data(), bytes.size());
+
+    return View(memory, bytes.size());
+}
+
+void Arena::Reset() {
+    current = 0;
+    offset = 0;
+    used = 0;
+}
+
+size_t Arena::Used() const {
+    return used;
+}
+
+size_t Arena::Capacity() const {
+    size_t capacity = 0;
+
+    for (const Block & block : blocks) {
+        capacity += block.capacity;
+    }
+
+    return capacity;
+}
+
+Arena & ChunkArena() {
+    static thread_local Arena arena;
+
+    return arena;
+}
+
+} // End File
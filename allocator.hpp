@@ -0,0 +1,95 @@
+#ifndef FILE_ALLOCATOR_H
+#define FILE_ALLOCATOR_H
+
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+#include "view.hpp"
+
+namespace File
+{
+
+// Where readers get their buffers from. Every buffer is at least 64 byte aligned, and the
+// capacity handed out on allocation is passed back when freeing.
+class BufferAllocator
+{
+public:
+  typedef std::function<char *(size_t size, size_t *capacity)> AllocateFunction;
+  typedef std::function<void(char *memory, size_t capacity)> FreeFunction;
+
+  BufferAllocator(AllocateFunction allocate, FreeFunction free);
+
+  // At least size bytes, nullptr on failure.
+  char *Allocate(size_t size, size_t *capacity) const;
+  void Free(char *memory, size_t capacity) const;
+
+  // Straight from the heap.
+  static const BufferAllocator &Heap();
+
+  // Power of two size classes from 4 KiB to 64 MiB, with a free list per class and thread.
+  // Freed buffers are kept for reuse by the freeing thread, up to 64 MiB per thread, so
+  // readers opened one after another reuse each other's buffers without touching the heap
+  // or contending for its locks. This is the default.
+  static const BufferAllocator &Pooled();
+
+  // Hand the calling thread's cached buffers back to the heap. Pool workers do this when they
+  // have been idle for a while, so long lived pools don't sit on them.
+  static void Trim();
+
+  // Bytes the calling thread holds for reuse.
+  static size_t CachedBytes();
+
+private:
+  AllocateFunction allocate;
+  FreeFunction free;
+};
+
+// A bump allocator for memory that lives as long as a chunk, like records unescaped by a
+// pipeline stage. Allocation is a pointer bump and Reset frees everything at once while
+// keeping the blocks, so a scan allocating into it settles at a fixed footprint.
+class Arena
+{
+public:
+  explicit Arena(size_t block_size = 1 << 16, const BufferAllocator &allocator = BufferAllocator::Pooled());
+  ~Arena();
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  // Alignment must be a power of two, at most 64.
+  char *Allocate(size_t size, size_t alignment = alignof(max_align_t));
+
+  // Copy bytes into the arena.
+  View Copy(const View &bytes);
+
+  // Forget every allocation, keeping the blocks for the next ones.
+  void Reset();
+
+  // Bytes handed out since the last reset, and bytes held.
+  size_t Used() const;
+  size_t Capacity() const;
+
+private:
+  struct Block
+  {
+    char *data;
+    size_t capacity;
+  };
+
+  const BufferAllocator &allocator;
+  size_t block_size;
+  std::vector<Block> blocks;
+  size_t current;
+  size_t offset;
+  size_t used;
+};
+
+// The calling thread's arena. Pipelines reset it after every chunk, and Parallel workers
+// after every batch, so stages can allocate records into it that live until then. Memory
+// from it must not be handed out of an OrderedMap function, whose results outlive the batch.
+Arena &ChunkArena();
+
+} // End File
+
+#endif // FILE_ALLOCATOR_H
@@ -0,0 +1,201 @@
+#ifndef FILE_ASYNC_READER_H
+#define FILE_ASYNC_READER_H
+
+// Awaitable reads for C++20 coroutines. Only available when the compiler supports them,
+// the rest of the library stays C++11.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <coroutine>
+#include <string>
+
+#include "file.hpp"
+#include "memory_budget.hpp"
+#include "thread_pool.hpp"
+
+namespace File
+{
+
+// The pool blocking reads are handed off to, shared by every AsyncReader by default.
+inline ThreadPool &IoPool()
+{
+  static ThreadPool pool(4);
+  return pool;
+}
+
+// Runs a reader's blocking reads on an I/O pool, so one thread can drive many scans
+// without stalling on any of them.
+//
+// Reads of data already in the page cache complete right away through TryRead, without
+// suspending. Only reads that would block go to the pool, and the awaiting coroutine is then
+// resumed on the pool thread that did the read, so chunks may come out shorter than the read
+// size when part of one is cached. A reader must only have one read in flight at a time.
+//
+// With a memory budget shared with other stages, a scan's chunk counts against it until the
+// next one is asked for or the file ends. A read that doesn't fit waits for room on the
+// pool, like one that would block, so the thread driving the scans never does.
+class AsyncReader
+{
+public:
+  explicit AsyncReader(Reader &reader, ThreadPool &pool = IoPool(), MemoryBudget *budget = nullptr) :
+    reader(reader),
+    pool(pool),
+    reserved(budget)
+  {}
+
+  class ReadAwaitable
+  {
+  public:
+    ReadAwaitable(AsyncReader &owner, std::string &buffer) : owner(owner), buffer(buffer) {}
+
+    bool await_ready()
+    {
+      // The last chunk is done with once the next one is asked for.
+      owner.reserved.Resize(0);
+
+      if (!owner.reserved.TryResize(owner.reader.ReadSize())) {
+        return false;
+      }
+
+      status = owner.reader.TryRead(buffer);
+
+      return !owner.reader.StatusWouldBlock(status);
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+      owner.pool.Submit([this, handle]() {
+        owner.reserved.Resize(owner.reader.ReadSize());
+        status = owner.reader.Read(buffer);
+        handle.resume();
+      });
+    }
+
+    Reader::READ_STATUS await_resume()
+    {
+      // A scan that has reached the end won't ask for another chunk.
+      if (owner.reader.StatusEndOfFile(status) || owner.reader.StatusError(status)) {
+        owner.reserved.Resize(0);
+      }
+
+      return status;
+    }
+
+  private:
+    AsyncReader &owner;
+    std::string &buffer;
+    Reader::READ_STATUS status = Reader::READ_STATUS::ERROR;
+  };
+
+  // co_await reader.ReadAsync(buffer) reads the next chunk, like Reader::Read(buffer).
+  ReadAwaitable ReadAsync(std::string &buffer) { return ReadAwaitable(*this, buffer); }
+
+  // The file as a stream of chunks:
+  //
+  // auto chunks = async.Chunks();
+  // while (co_await chunks.Next()) { use chunks.Current(); }
+  class ChunkStream
+  {
+  public:
+    explicit ChunkStream(AsyncReader &owner) : owner(owner) {}
+
+    class NextAwaitable
+    {
+    public:
+      explicit NextAwaitable(ChunkStream &stream) : stream(stream) {}
+
+      // Nothing left to read, or the next chunk is cached: no need to suspend.
+      bool await_ready() { return stream.done || stream.TryAdvance(); }
+
+      void await_suspend(std::coroutine_handle<> handle)
+      {
+        stream.owner.pool.Submit([this, handle]() {
+          stream.Advance();
+          handle.resume();
+        });
+      }
+
+      bool await_resume() const { return !stream.done; }
+
+    private:
+      ChunkStream &stream;
+    };
+
+    NextAwaitable Next() { return NextAwaitable(*this); }
+
+    // The chunk read by the last Next(), valid until the following one.
+    std::string &Current() { return chunk; }
+
+    // The status of the last read, to tell the end of the file from an error.
+    Reader::READ_STATUS Status() const { return status; }
+
+  private:
+    AsyncReader &owner;
+    std::string chunk;
+    Reader::READ_STATUS status = Reader::READ_STATUS::OK;
+    bool done = false;
+
+    void Advance()
+    {
+      if (owner.reader.StatusEndOfFile(status) || owner.reader.StatusError(status)) {
+        Finish();
+        return;
+      }
+
+      owner.reserved.Resize(owner.reader.ReadSize());
+      status = owner.reader.Read(chunk);
+
+      if (owner.reader.StatusError(status) || chunk.empty()) {
+        Finish();
+      }
+    }
+
+    // Advance if that doesn't block, returning whether it did.
+    bool TryAdvance()
+    {
+      if (owner.reader.StatusEndOfFile(status) || owner.reader.StatusError(status)) {
+        Finish();
+        return true;
+      }
+
+      // The current chunk is done with once the next one is asked for.
+      owner.reserved.Resize(0);
+
+      if (!owner.reserved.TryResize(owner.reader.ReadSize())) {
+        return false;
+      }
+
+      Reader::READ_STATUS attempt = owner.reader.TryRead(chunk);
+
+      if (owner.reader.StatusWouldBlock(attempt)) {
+        return false;
+      }
+
+      status = attempt;
+
+      if (owner.reader.StatusError(status) || chunk.empty()) {
+        Finish();
+      }
+
+      return true;
+    }
+
+    void Finish()
+    {
+      done = true;
+      owner.reserved.Resize(0);
+    }
+  };
+
+  ChunkStream Chunks() { return ChunkStream(*this); }
+
+private:
+  Reader &reader;
+  ThreadPool &pool;
+  MemoryReservation reserved;
+};
+
+} // End File
+
+#endif // __cpp_impl_coroutine
+
+#endif // FILE_ASYNC_READER_H
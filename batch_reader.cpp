@@ -0,0 +1,246 @@
+#include "batch_reader.hpp"
+#include "memory_budget.hpp"
+#include "thread_pool.hpp"
+
+#include <dirent.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace File {
+
+namespace {
+
+const size_t DEFAULT_MAX_BUFFERED_BYTES = 64 << 20;
+
+struct Item
+{
+  size_t file;
+  std::string chunk;
+  bool done;
+  Reader::READ_STATUS status;
+};
+
+// Hands chunks from the workers to the calling thread, holding back workers once the chunks
+// waiting use up the memory budget.
+class ChunkQueue
+{
+public:
+  explicit ChunkQueue(MemoryBudget &budget) :
+    budget(budget)
+  {}
+
+  // Reserve room for a chunk before reading it.
+  void Reserve(size_t bytes)
+  {
+    budget.Reserve(bytes);
+  }
+
+  void Release(size_t bytes)
+  {
+    budget.Release(bytes);
+  }
+
+  void Push(Item item)
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      items.push_back(std::move(item));
+    }
+
+    available.notify_one();
+  }
+
+  Item Pop()
+  {
+    std::unique_lock<std::mutex> guard(lock);
+
+    available.wait(guard, [this]() {
+      return !items.empty();
+    });
+
+    Item item = std::move(items.front());
+    items.pop_front();
+
+    return item;
+  }
+
+private:
+  MemoryBudget &budget;
+  std::deque<Item> items;
+  std::mutex lock;
+  std::condition_variable available;
+};
+
+void ReadFile(size_t file, const std::string & path, size_t read_size, ChunkQueue & queue) {
+    Item done;
+    done.file = file;
+    done.done = true;
+
+    Reader reader;
+
+    if (!File::StatusOk(reader.Open(path))) {
+        done.status = Reader::READ_STATUS::ERROR;
+        queue.Push(std::move(done));
+        return;
+    }
+
+    if (read_size > 0) {
+        reader.SetReadSize(read_size);
+    }
+
+    const size_t reservation = read_size > 0 ? read_size : reader.Stat().st_blksize;
+
+    while (true) {
+        Item item;
+        item.file = file;
+        item.done = false;
+
+        queue.Reserve(reservation);
+
+        item.status = reader.Read(item.chunk);
+
+        if (reader.StatusError(item.status)) {
+            queue.Release(reservation);
+            done.status = item.status;
+            break;
+        }
+
+        // Swap the reservation for what was actually read.
+        queue.Release(reservation - item.chunk.size());
+
+        bool end_of_file = reader.StatusEndOfFile(item.status);
+
+        if (!item.chunk.empty()) {
+            queue.Push(std::move(item));
+        }
+
+        if (end_of_file) {
+            done.status = Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+            break;
+        }
+    }
+
+    queue.Push(std::move(done));
+}
+
+} // End anonymous namespace
+
+BatchReader::BatchReader(size_t threads) :
+    threads(threads),
+    read_size(0),
+    max_buffered_bytes(DEFAULT_MAX_BUFFERED_BYTES),
+    budget(nullptr)
+{}
+
+BatchReader & BatchReader::SetReadSize(size_t size) {
+    read_size = size;
+
+    return *this;
+}
+
+BatchReader & BatchReader::SetMaxBufferedBytes(size_t bytes) {
+    max_buffered_bytes = bytes;
+
+    return *this;
+}
+
+BatchReader & BatchReader::SetMemoryBudget(MemoryBudget * shared_budget) {
+    budget = shared_budget;
+
+    return *this;
+}
+
+Reader::READ_STATUS BatchReader::Read(const std::vector<std::string> & paths,
+                                      std::function<void(size_t, std::string &)> callback,
+                                      std::function<void(size_t, Reader::READ_STATUS)> done_callback) {
+    MemoryBudget own_budget(max_buffered_bytes);
+    ChunkQueue queue(budget != nullptr ? *budget : own_budget);
+    ThreadPool pool(threads);
+
+    for (size_t file = 0; file < paths.size(); file++) {
+        const std::string &path = paths[file];
+        const size_t size = read_size;
+
+        pool.Submit([file, &path, size, &queue]() {
+            ReadFile(file, path, size, queue);
+        });
+    }
+
+    Reader::READ_STATUS result = Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+    size_t remaining = paths.size();
+
+    while (remaining > 0) {
+        Item item = queue.Pop();
+
+        if (item.done) {
+            remaining--;
+
+            if ((item.status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR) {
+                result = Reader::READ_STATUS::ERROR;
+            }
+
+            if (done_callback) {
+                done_callback(item.file, item.status);
+            }
+
+            continue;
+        }
+
+        callback(item.file, item.chunk);
+        queue.Release(item.chunk.size());
+    }
+
+    return result;
+}
+
+std::vector<std::string> BatchReader::ListDirectory(const std::string & directory, bool recursive) {
+    std::vector<std::string> files;
+    std::vector<std::string> pending(1, directory);
+
+    while (!pending.empty()) {
+        std::string current = pending.back();
+        pending.pop_back();
+
+        DIR *handle = opendir(current.c_str());
+
+        if (handle == nullptr) {
+            continue;
+        }
+
+        struct dirent *entry;
+
+        while ((entry = readdir(handle)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+
+            std::string path = current + "/" + entry->d_name;
+            unsigned char type = entry->d_type;
+
+            // Not every filesystem fills in d_type.
+            if (type == DT_UNKNOWN) {
+                struct stat path_stat;
+
+                if (lstat(path.c_str(), &path_stat) == -1) {
+                    continue;
+                }
+
+                type = S_ISREG(path_stat.st_mode) ? DT_REG : S_ISDIR(path_stat.st_mode) ? DT_DIR : DT_UNKNOWN;
+            }
+
+            if (type == DT_REG) {
+                files.push_back(path);
+            } else if (type == DT_DIR && recursive) {
+                pending.push_back(path);
+            }
+        }
+
+        closedir(handle);
+    }
+
+    return files;
+}
+
+} // End File
@@ -0,0 +1,55 @@
+#ifndef FILE_BATCH_READER_H
+#define FILE_BATCH_READER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "file.hpp"
+
+namespace File
+{
+
+class MemoryBudget;
+
+// Reads many (typically small) files concurrently on a pool of workers, so that opening and
+// reading one file overlaps with the others instead of leaving the disk idle in between.
+//
+// Callbacks always run on the calling thread. Chunks of one file arrive in order, chunks of
+// different files interleave. Workers stop reading ahead once the chunks waiting to be handed
+// out reach the buffered bytes limit, which bounds the memory used.
+class BatchReader
+{
+public:
+  // Zero threads means one per hardware thread.
+  explicit BatchReader(size_t threads = 0);
+
+  // Chunk size used for every file, their optimal block size by default.
+  BatchReader &SetReadSize(size_t size);
+
+  BatchReader &SetMaxBufferedBytes(size_t bytes);
+
+  // Count buffered chunks against a budget shared with other stages, instead of the
+  // buffered bytes limit.
+  BatchReader &SetMemoryBudget(MemoryBudget *budget);
+
+  // Read every file, handing each chunk to callback along with the file's index in paths.
+  // done_callback, if given, receives the final status of each file, including files that
+  // couldn't be opened. Returns ERROR if any file failed.
+  Reader::READ_STATUS Read(const std::vector<std::string> &paths,
+                           std::function<void(size_t, std::string &)> callback,
+                           std::function<void(size_t, Reader::READ_STATUS)> done_callback = nullptr);
+
+  // List the regular files in a directory, optionally descending into subdirectories.
+  static std::vector<std::string> ListDirectory(const std::string &directory, bool recursive = false);
+
+private:
+  size_t threads;
+  size_t read_size;
+  size_t max_buffered_bytes;
+  MemoryBudget *budget;
+};
+
+} // End File
+
+#endif // FILE_BATCH_READER_H
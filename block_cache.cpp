@@ -0,0 +1,180 @@
+#include "block_cache.hpp"
+
+namespace File {
+
+namespace {
+
+const size_t DEFAULT_GLOBAL_CAPACITY = 256 << 20;
+
+} // End anonymous namespace
+
+size_t BlockCache::KeyHash::operator()(const Key & key) const {
+    uint64_t hash = key.block * 0x9E3779B97F4A7C15ull;
+
+    hash ^= static_cast<uint64_t>(key.inode) + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+    hash ^= static_cast<uint64_t>(key.device) + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+
+    return static_cast<size_t>(hash);
+}
+
+BlockCache::BlockCache(size_t capacity, size_t block_size, size_t shard_count) :
+    block_size(block_size > 0 ? block_size : 1),
+    hits(0),
+    misses(0)
+{
+    shard_count = shard_count > 0 ? shard_count : 1;
+
+    for (size_t i = 0; i < shard_count; i++) {
+        shards.emplace_back(new Shard());
+        shards.back()->hand = 0;
+        shards.back()->size = 0;
+    }
+
+    SetCapacity(capacity);
+}
+
+BlockCache & BlockCache::Global() {
+    static BlockCache cache(DEFAULT_GLOBAL_CAPACITY);
+
+    return cache;
+}
+
+size_t BlockCache::BlockSize() const {
+    return block_size;
+}
+
+void BlockCache::SetCapacity(size_t capacity) {
+    for (std::unique_ptr<Shard> & shard : shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+
+        shard->capacity = capacity / shards.size();
+        Evict(*shard, 0);
+    }
+}
+
+BlockCache::Shard & BlockCache::ShardFor(const Key & key) {
+    // The low bits pick the bucket inside the shard, so use the high bits to pick the shard.
+    return *shards[(KeyHash()(key) >> 48) % shards.size()];
+}
+
+BlockCache::Block BlockCache::Get(const struct stat & file_stat, uint64_t block) {
+    Key key = {file_stat.st_dev, file_stat.st_ino, block};
+    Shard &shard = ShardFor(key);
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    auto found = shard.index.find(key);
+
+    if (found == shard.index.end()) {
+        misses++;
+        return Block();
+    }
+
+    Entry &entry = shard.entries[found->second];
+
+    // The file changed since the block was cached.
+    if (entry.file_size != file_stat.st_size || entry.modified.tv_sec != file_stat.st_mtim.tv_sec ||
+        entry.modified.tv_nsec != file_stat.st_mtim.tv_nsec) {
+        Remove(shard, found->second);
+        misses++;
+        return Block();
+    }
+
+    entry.referenced = true;
+    hits++;
+
+    return entry.data;
+}
+
+void BlockCache::Put(const struct stat & file_stat, uint64_t block, Block data) {
+    Key key = {file_stat.st_dev, file_stat.st_ino, block};
+    Shard &shard = ShardFor(key);
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    if (data->size() > shard.capacity) {
+        return;
+    }
+
+    auto found = shard.index.find(key);
+
+    if (found != shard.index.end()) {
+        Remove(shard, found->second);
+    }
+
+    Evict(shard, data->size());
+
+    Entry entry;
+    entry.key = key;
+    entry.data = data;
+    entry.file_size = file_stat.st_size;
+    entry.modified = file_stat.st_mtim;
+    entry.referenced = false;
+
+    shard.size += data->size();
+    shard.index[key] = shard.entries.size();
+    shard.entries.push_back(std::move(entry));
+}
+
+void BlockCache::Evict(Shard & shard, size_t bytes) {
+    // CLOCK: sweep the entries, giving referenced ones a second chance.
+    while (!shard.entries.empty() && shard.size + bytes > shard.capacity) {
+        if (shard.hand >= shard.entries.size()) {
+            shard.hand = 0;
+        }
+
+        Entry &entry = shard.entries[shard.hand];
+
+        if (entry.referenced) {
+            entry.referenced = false;
+            shard.hand++;
+        } else {
+            Remove(shard, shard.hand);
+        }
+    }
+}
+
+void BlockCache::Remove(Shard & shard, size_t slot) {
+    shard.size -= shard.entries[slot].data->size();
+    shard.index.erase(shard.entries[slot].key);
+
+    // Fill the hole with the last entry to keep the entries packed.
+    if (slot != shard.entries.size() - 1) {
+        shard.entries[slot] = std::move(shard.entries.back());
+        shard.index[shard.entries[slot].key] = slot;
+    }
+
+    shard.entries.pop_back();
+}
+
+void BlockCache::Clear() {
+    for (std::unique_ptr<Shard> & shard : shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+
+        shard->entries.clear();
+        shard->index.clear();
+        shard->hand = 0;
+        shard->size = 0;
+    }
+}
+
+uint64_t BlockCache::Hits() const {
+    return hits;
+}
+
+uint64_t BlockCache::Misses() const {
+    return misses;
+}
+
+size_t BlockCache::Size() const {
+    size_t size = 0;
+
+    for (const std::unique_ptr<Shard> & shard : shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        size += shard->size;
+    }
+
+    return size;
+}
+
+} // End File
@@ -0,0 +1,105 @@
+#ifndef FILE_BLOCK_CACHE_H
+#define FILE_BLOCK_CACHE_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace File
+{
+
+// A cache of file blocks shared between readers, so hot files are served from user space
+// instead of going back to the kernel for every read.
+//
+// Blocks are keyed by (device, inode, block index) and remember the file's size and mtime,
+// a block cached from an older version of the file is dropped on lookup. The cache is split
+// into shards, each with its own lock and CLOCK eviction over its share of the capacity.
+// Blocks are shared pointers, so a block evicted while a reader is copying out of it stays
+// alive until the reader is done.
+class BlockCache
+{
+public:
+  typedef std::shared_ptr<const std::string> Block;
+
+  explicit BlockCache(size_t capacity, size_t block_size = 1 << 16, size_t shard_count = 16);
+
+  // A cache for the whole process, 256 MiB by default.
+  static BlockCache &Global();
+
+  size_t BlockSize() const;
+
+  // Evicts blocks as needed to fit a smaller capacity.
+  void SetCapacity(size_t capacity);
+
+  // The cached block, or an empty pointer if it's missing or stale.
+  Block Get(const struct stat &file_stat, uint64_t block);
+
+  void Put(const struct stat &file_stat, uint64_t block, Block data);
+
+  void Clear();
+
+  uint64_t Hits() const;
+  uint64_t Misses() const;
+
+  // Bytes currently cached.
+  size_t Size() const;
+
+private:
+  struct Key
+  {
+    dev_t device;
+    ino_t inode;
+    uint64_t block;
+
+    bool operator==(const Key &other) const
+    {
+      return device == other.device && inode == other.inode && block == other.block;
+    }
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(const Key &key) const;
+  };
+
+  struct Entry
+  {
+    Key key;
+    Block data;
+    off_t file_size;
+    struct timespec modified;
+    bool referenced;
+  };
+
+  struct Shard
+  {
+    std::mutex lock;
+    std::vector<Entry> entries;
+    std::unordered_map<Key, size_t, KeyHash> index;
+    size_t hand;
+    size_t size;
+    size_t capacity;
+  };
+
+  size_t block_size;
+  std::vector<std::unique_ptr<Shard>> shards;
+
+  std::atomic<uint64_t> hits;
+  std::atomic<uint64_t> misses;
+
+  Shard &ShardFor(const Key &key);
+
+  // Evict until the shard has room for bytes more. The shard must be locked.
+  void Evict(Shard &shard, size_t bytes);
+  void Remove(Shard &shard, size_t slot);
+};
+
+} // End File
+
+#endif // FILE_BLOCK_CACHE_H
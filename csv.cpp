@@ -0,0 +1,254 @@
+#include "csv.hpp"
+
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace File {
+
+namespace {
+
+const size_t BLOCK_SIZE = 64;
+
+// Bit i of the result is set when an odd number of bits at or below i are set.
+uint64_t PrefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+
+    return bits;
+}
+
+#ifdef __SSE2__
+uint64_t Compare(const __m128i * blocks, char byte) {
+    const __m128i needle = _mm_set1_epi8(byte);
+    uint64_t mask = 0;
+
+    for (int i = 0; i < 4; i++) {
+        uint64_t bits = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(blocks[i], needle)));
+        mask |= bits << (16 * i);
+    }
+
+    return mask;
+}
+#endif
+
+} // End anonymous namespace
+
+CsvParser::CsvParser(char delimiter, char quote) :
+    delimiter(delimiter),
+    quote(quote),
+    carry_in_quotes(false)
+{}
+
+void CsvParser::Masks(const char * block, size_t length, uint64_t & delimiters, uint64_t & quotes, uint64_t & newlines) const {
+#ifdef __SSE2__
+    if (length == BLOCK_SIZE) {
+        __m128i blocks[4];
+
+        for (int i = 0; i < 4; i++) {
+            blocks[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        }
+
+        delimiters = Compare(blocks, delimiter);
+        newlines = Compare(blocks, '\n');
+        quotes = quote == '\0' ? 0 : Compare(blocks, quote);
+
+        return;
+    }
+#endif
+
+    delimiters = quotes = newlines = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        uint64_t bit = static_cast<uint64_t>(1) << i;
+        char c = block[i];
+
+        if (c == delimiter) {
+            delimiters |= bit;
+        } else if (c == '\n') {
+            newlines |= bit;
+        } else if (c == quote && quote != '\0') {
+            quotes |= bit;
+        }
+    }
+}
+
+const char *CsvParser::FindRowEnd(const char * begin, const char * end, bool & in_quotes) const {
+    uint64_t quote_state = in_quotes ? ~static_cast<uint64_t>(0) : 0;
+
+    for (const char *block = begin; block < end; block += BLOCK_SIZE) {
+        size_t remaining = end - block;
+        size_t length = remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE;
+        uint64_t delimiters, quotes, newlines;
+
+        Masks(block, length, delimiters, quotes, newlines);
+
+        uint64_t quoted = PrefixXor(quotes) ^ quote_state;
+        uint64_t row_ends = newlines & ~quoted;
+
+        if (row_ends != 0) {
+            in_quotes = false;
+
+            return block + __builtin_ctzll(row_ends);
+        }
+
+        // Bits past the end of a short block repeat the state of its last byte.
+        quote_state = (quoted >> 63) ? ~static_cast<uint64_t>(0) : 0;
+    }
+
+    in_quotes = quote_state != 0;
+
+    return nullptr;
+}
+
+void CsvParser::EndRow(const char * field_start, const char * row_end, std::function<void(const std::vector<View> &)> & callback) {
+    // Rows ending in "\r\n" shouldn't leave the '\r' on their last field.
+    if (row_end > field_start && *(row_end - 1) == '\r') {
+        row_end--;
+    }
+
+    fields.push_back(View(field_start, row_end - field_start));
+    callback(fields);
+    fields.clear();
+}
+
+const char *CsvParser::ScanRows(const char * begin, const char * end, bool & in_quotes, bool final,
+                                std::function<void(const std::vector<View> &)> & callback) {
+    fields.clear();
+
+    const char *field_start = begin;
+    const char *row_start = begin;
+    uint64_t quote_state = in_quotes ? ~static_cast<uint64_t>(0) : 0;
+
+    for (const char *block = begin; block < end; block += BLOCK_SIZE) {
+        size_t remaining = end - block;
+        size_t length = remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE;
+        uint64_t delimiters, quotes, newlines;
+
+        Masks(block, length, delimiters, quotes, newlines);
+
+        uint64_t quoted = PrefixXor(quotes) ^ quote_state;
+        uint64_t structurals = (delimiters | newlines) & ~quoted;
+
+        quote_state = (quoted >> 63) ? ~static_cast<uint64_t>(0) : 0;
+
+        while (structurals != 0) {
+            int bit = __builtin_ctzll(structurals);
+            const char *position = block + bit;
+
+            if ((newlines >> bit) & 1) {
+                EndRow(field_start, position, callback);
+                row_start = position + 1;
+            } else {
+                fields.push_back(View(field_start, position - field_start));
+            }
+
+            field_start = position + 1;
+            structurals &= structurals - 1;
+        }
+    }
+
+    in_quotes = quote_state != 0;
+
+    if (final && row_start < end) {
+        EndRow(field_start, end, callback);
+        row_start = end;
+    }
+
+    fields.clear();
+
+    return row_start;
+}
+
+void CsvParser::Feed(const char * data, size_t size, std::function<void(const std::vector<View> &)> callback) {
+    const char *begin = data;
+    const char *end = data + size;
+
+    // Finish the row carried over from the last chunk first.
+    if (!carry.empty()) {
+        const char *row_end = FindRowEnd(begin, end, carry_in_quotes);
+
+        if (row_end == nullptr) {
+            carry.append(begin, end - begin);
+            return;
+        }
+
+        carry.append(begin, row_end + 1 - begin);
+
+        bool in_quotes = false;
+        ScanRows(carry.data(), carry.data() + carry.size(), in_quotes, false, callback);
+
+        carry.clear();
+        begin = row_end + 1;
+    }
+
+    bool in_quotes = false;
+    const char *row_start = ScanRows(begin, end, in_quotes, false, callback);
+
+    carry.assign(row_start, end - row_start);
+    carry_in_quotes = in_quotes;
+}
+
+void CsvParser::Feed(const std::string & chunk, std::function<void(const std::vector<View> &)> callback) {
+    Feed(chunk.data(), chunk.size(), callback);
+}
+
+void CsvParser::Finish(std::function<void(const std::vector<View> &)> callback) {
+    if (!carry.empty()) {
+        bool in_quotes = false;
+        ScanRows(carry.data(), carry.data() + carry.size(), in_quotes, true, callback);
+    }
+
+    Reset();
+}
+
+Reader::READ_STATUS CsvParser::Parse(Reader & reader, std::function<void(const std::vector<View> &)> callback) {
+    Reader::READ_STATUS status = reader.Read([&](std::string & chunk) {
+        Feed(chunk, callback);
+    });
+
+    if (!reader.StatusError(status)) {
+        Finish(callback);
+    }
+
+    return status;
+}
+
+View CsvParser::Unquote(const View & field, std::string & scratch) const {
+    if (quote == '\0' || field.size() < 2 || field[0] != quote || field[field.size() - 1] != quote) {
+        return field;
+    }
+
+    View inner = field.substr(1, field.size() - 2);
+
+    if (memchr(inner.data(), quote, inner.size()) == nullptr) {
+        return inner;
+    }
+
+    scratch.clear();
+
+    for (size_t i = 0; i < inner.size(); i++) {
+        scratch += inner[i];
+
+        // Escaped quotes are doubled.
+        if (inner[i] == quote && i + 1 < inner.size() && inner[i + 1] == quote) {
+            i++;
+        }
+    }
+
+    return View(scratch);
+}
+
+void CsvParser::Reset() {
+    fields.clear();
+    carry.clear();
+    carry_in_quotes = false;
+}
+
+} // End File
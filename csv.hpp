@@ -0,0 +1,70 @@
+#ifndef FILE_CSV_H
+#define FILE_CSV_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "file.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+// Splits delimited text (CSV, TSV, ...) into rows of field views.
+//
+// Each 64 byte block is turned into bitmasks of delimiters, quotes and newlines (with SSE2
+// where available). A prefix xor over the quote mask marks the quoted regions, leaving only
+// the delimiters and newlines that actually separate fields to visit.
+//
+// Fields are handed out raw, quoted fields still carry their quotes, see Unquote. Rows that
+// span chunks are carried over, so views are only valid during the callback.
+class CsvParser
+{
+public:
+  // A quote of '\0' disables quoting, which suits plain TSV.
+  explicit CsvParser(char delimiter = ',', char quote = '"');
+
+  // Feed the next chunk, receiving every row it completes.
+  void Feed(const char *data, size_t size, std::function<void(const std::vector<View> &)> callback);
+  void Feed(const std::string &chunk, std::function<void(const std::vector<View> &)> callback);
+
+  // Hand out the final row if the stream didn't end with a newline.
+  void Finish(std::function<void(const std::vector<View> &)> callback);
+
+  // Parse every row of the reader's stream.
+  Reader::READ_STATUS Parse(Reader &reader, std::function<void(const std::vector<View> &)> callback);
+
+  // Strip a field's quotes. Only fields containing escaped ("") quotes are copied, into scratch.
+  View Unquote(const View &field, std::string &scratch) const;
+
+  // Forget any partial row.
+  void Reset();
+
+private:
+  char delimiter;
+  char quote;
+
+  // Reused for every row.
+  std::vector<View> fields;
+
+  // The unfinished row at the end of the last chunk, and whether it ends inside quotes.
+  std::string carry;
+  bool carry_in_quotes;
+
+  void Masks(const char *block, size_t length, uint64_t &delimiters, uint64_t &quotes, uint64_t &newlines) const;
+
+  // Find the first newline outside of quotes, given the quote state at begin.
+  const char *FindRowEnd(const char *begin, const char *end, bool &in_quotes) const;
+
+  // Hand out every complete row in [begin, end), returning where the incomplete row starts.
+  const char *ScanRows(const char *begin, const char *end, bool &in_quotes, bool final,
+                       std::function<void(const std::vector<View> &)> &callback);
+
+  void EndRow(const char *field_start, const char *row_end, std::function<void(const std::vector<View> &)> &callback);
+};
+
+} // End File
+
+#endif // FILE_CSV_H
@@ -0,0 +1,711 @@
+#include "external_sort.hpp"
+#include "memory_budget.hpp"
+#include "page_buffer.hpp"
+#include "thread_pool.hpp"
+#include "view.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace File {
+
+namespace {
+
+const size_t DEFAULT_MEMORY_LIMIT = 256 << 20;
+const size_t DEFAULT_MERGE_READ_SIZE = 1 << 20;
+const size_t WRITE_SIZE = 1 << 20;
+
+// Below this many lines per slice, sorting on more threads isn't worth it.
+const size_t MIN_SLICE_LINES = 1 << 14;
+
+// A line in the run buffer, with its first 8 bytes as a big endian key so most comparisons
+// never touch the line itself.
+struct Line
+{
+    uint64_t prefix;
+    const char *data;
+    size_t size;
+};
+
+uint64_t Prefix(const char * data, size_t size) {
+    uint64_t prefix = 0;
+
+    for (size_t i = 0; i < 8; i++) {
+        prefix = (prefix << 8) | (i < size ? static_cast<unsigned char>(data[i]) : 0);
+    }
+
+    return prefix;
+}
+
+int Compare(const char * a, size_t a_size, const char * b, size_t b_size) {
+    int result = memcmp(a, b, std::min(a_size, b_size));
+
+    if (result != 0) {
+        return result;
+    }
+
+    return a_size < b_size ? -1 : a_size > b_size ? 1 : 0;
+}
+
+bool LineLess(const Line & a, const Line & b) {
+    if (a.prefix != b.prefix) {
+        return a.prefix < b.prefix;
+    }
+
+    return Compare(a.data, a.size, b.data, b.size) < 0;
+}
+
+// A tournament tree over k sorted sources. Each internal node keeps the loser of the match
+// played there, so replacing the winner's head only replays the matches on its path to the
+// root: log2(k) comparisons, against log2(k) * 2 for a heap.
+//
+// less compares the heads of two sources, an exhausted source must compare greater than any
+// other. Ties go to the lower source.
+template <typename Less>
+class LoserTree
+{
+public:
+  LoserTree(size_t sources, Less less) :
+    sources(sources),
+    less(less),
+    tree(sources, sources)
+  {
+    // Sources enter from the last, the first to reach a node waits there for its opponent.
+    for (size_t source = sources; source-- > 0;) {
+      Replay(source);
+    }
+  }
+
+  size_t Winner() const { return tree[0]; }
+
+  // Play the source's way up to the root after its head changed.
+  void Replay(size_t source)
+  {
+    size_t winner = source;
+
+    for (size_t node = (source + sources) / 2; node > 0; node /= 2) {
+      if (tree[node] == sources) {
+        tree[node] = winner;
+        return;
+      }
+
+      if (Beats(tree[node], winner)) {
+        std::swap(tree[node], winner);
+      }
+    }
+
+    tree[0] = winner;
+  }
+
+private:
+  size_t sources;
+  Less less;
+
+  // tree[0] is the overall winner, tree[1..sources) the losers, sources marks an empty node.
+  std::vector<size_t> tree;
+
+  bool Beats(size_t a, size_t b)
+  {
+    return less(a, b) || (!less(b, a) && a < b);
+  }
+};
+
+// Buffered sequential writes of lines.
+class Writer
+{
+public:
+  Writer() :
+    descriptor(-1),
+    failed(false)
+  {}
+
+  ~Writer()
+  {
+    Close();
+  }
+
+  bool Open(const std::string &path)
+  {
+    descriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    return descriptor != -1;
+  }
+
+  // Create a new file in directory, setting path to its name.
+  bool OpenTemporary(const std::string &directory, std::string &path)
+  {
+    std::string name = directory + "/file-sort-run-XXXXXX";
+    descriptor = mkstemp(&name[0]);
+    path = name;
+
+    return descriptor != -1;
+  }
+
+  void WriteLine(const char *data, size_t size)
+  {
+    buffer.append(data, size);
+    buffer += '\n';
+
+    if (buffer.size() >= WRITE_SIZE) {
+      Flush();
+    }
+  }
+
+  // Flush and close, returning whether every write succeeded.
+  bool Close()
+  {
+    if (descriptor == -1) {
+      return !failed;
+    }
+
+    Flush();
+
+    if (close(descriptor) == -1) {
+      failed = true;
+    }
+
+    descriptor = -1;
+
+    return !failed;
+  }
+
+private:
+  int descriptor;
+  bool failed;
+  std::string buffer;
+
+  void Flush()
+  {
+    const char *data = buffer.data();
+    size_t left = buffer.size();
+
+    while (left > 0 && !failed) {
+      ssize_t written = write(descriptor, data, left);
+
+      if (written == -1) {
+        failed = errno != EINTR;
+        continue;
+      }
+
+      data += written;
+      left -= written;
+    }
+
+    buffer.clear();
+  }
+};
+
+// Reads a run's lines in order, reading the next block on the pool while the current one is
+// being merged.
+class RunReader
+{
+public:
+  explicit RunReader(ThreadPool &pool) :
+    pool(pool),
+    block_size(0),
+    position(0),
+    carried(false),
+    pending(false),
+    next_status(Reader::READ_STATUS::OK),
+    end_of_file(false),
+    done(false),
+    status(Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE)
+  {}
+
+  ~RunReader()
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    ready.wait(guard, [this]() { return !pending; });
+  }
+
+  bool Open(const std::string &path, size_t read_size)
+  {
+    if (!File::StatusOk(reader.Open(path))) {
+      return false;
+    }
+
+    block_size = read_size;
+    Prefetch();
+
+    return true;
+  }
+
+  // Move to the next line, returning false once the run is exhausted or failed.
+  bool Next()
+  {
+    if (carried) {
+      carry.clear();
+      carried = false;
+    }
+
+    while (!done) {
+      const char *start = current.data() + position;
+      size_t left = current.size() - position;
+      const char *newline = static_cast<const char *>(memchr(start, '\n', left));
+
+      if (newline != nullptr) {
+        size_t size = newline - start;
+        position += size + 1;
+
+        // A line split across blocks is put back together in carry.
+        if (!carry.empty()) {
+          carry.append(start, size);
+          line = View(carry);
+          carried = true;
+        } else {
+          line = View(start, size);
+        }
+
+        return true;
+      }
+
+      carry.append(start, left);
+      position = current.size();
+
+      if (!Swap()) {
+        // Runs end with a newline, but don't drop a line if one doesn't. The run is only
+        // done on the next call, once the line has been merged.
+        if (!carry.empty() && !File::StatusError(status)) {
+          line = View(carry);
+          carried = true;
+          return true;
+        }
+
+        done = true;
+      }
+    }
+
+    return false;
+  }
+
+  const View &Line() const { return line; }
+  bool Done() const { return done; }
+  Reader::READ_STATUS Status() const { return status; }
+
+private:
+  ThreadPool &pool;
+  Reader reader;
+  size_t block_size;
+
+  std::string current;
+  size_t position;
+  std::string carry;
+  bool carried;
+  View line;
+
+  // The block being read ahead, guarded by lock while pending.
+  std::string next;
+  std::mutex lock;
+  std::condition_variable ready;
+  bool pending;
+  Reader::READ_STATUS next_status;
+
+  bool end_of_file;
+  bool done;
+  Reader::READ_STATUS status;
+
+  void Prefetch()
+  {
+    pending = true;
+
+    pool.Submit([this]() {
+      // Straight into the block, reading into a string would keep a third one in the reader.
+      ssize_t bytes_read = 0;
+      next.resize(block_size);
+
+      Reader::READ_STATUS read_status = reader.Read(&next[0], block_size, &bytes_read);
+      next.resize(bytes_read);
+
+      std::lock_guard<std::mutex> guard(lock);
+      next_status = read_status;
+      pending = false;
+      ready.notify_all();
+    });
+  }
+
+  // Make the prefetched block current and start reading the one after it. Returns false
+  // when there's nothing left or the read failed.
+  bool Swap()
+  {
+    if (end_of_file) {
+      return false;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    ready.wait(guard, [this]() { return !pending; });
+
+    if (reader.StatusError(next_status)) {
+      status = next_status;
+      return false;
+    }
+
+    current.swap(next);
+    position = 0;
+    end_of_file = reader.StatusEndOfFile(next_status);
+
+    if (!end_of_file) {
+      Prefetch();
+    }
+
+    return true;
+  }
+};
+
+// Merge runs [first, first + count) of paths into writer.
+Reader::READ_STATUS MergeRuns(const std::vector<std::string> & paths, size_t first, size_t count, Writer & writer,
+                              ThreadPool & pool, size_t read_size, MemoryBudget * budget) {
+    if (count == 0) {
+        return Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+    }
+
+    // Two blocks per run.
+    MemoryReservation reserved(budget, count * 2 * read_size);
+
+    std::vector<std::unique_ptr<RunReader>> runs;
+
+    for (size_t i = 0; i < count; i++) {
+        runs.emplace_back(new RunReader(pool));
+
+        if (!runs.back()->Open(paths[first + i], read_size)) {
+            return Reader::READ_STATUS::ERROR;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        runs[i]->Next();
+    }
+
+    auto less = [&runs](size_t a, size_t b) {
+        if (runs[a]->Done() || runs[b]->Done()) {
+            return !runs[a]->Done() && runs[b]->Done();
+        }
+
+        const View &x = runs[a]->Line();
+        const View &y = runs[b]->Line();
+
+        return Compare(x.data(), x.size(), y.data(), y.size()) < 0;
+    };
+
+    LoserTree<decltype(less)> tree(count, less);
+
+    while (!runs[tree.Winner()]->Done()) {
+        size_t winner = tree.Winner();
+        const View &line = runs[winner]->Line();
+
+        writer.WriteLine(line.data(), line.size());
+        runs[winner]->Next();
+        tree.Replay(winner);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (File::StatusError(runs[i]->Status())) {
+            return Reader::READ_STATUS::ERROR;
+        }
+    }
+
+    return Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+}
+
+// Sort lines in slices on the pool, then merge the slices into writer.
+void WriteRun(std::vector<Line> & lines, ThreadPool & pool, Writer & writer) {
+    size_t slices = std::max<size_t>(1, std::min(pool.Size(), lines.size() / MIN_SLICE_LINES));
+    std::vector<size_t> positions(slices);
+    std::vector<size_t> ends(slices);
+
+    for (size_t slice = 0; slice < slices; slice++) {
+        positions[slice] = lines.size() * slice / slices;
+        ends[slice] = lines.size() * (slice + 1) / slices;
+
+        Line *begin = lines.data() + positions[slice];
+        Line *end = lines.data() + ends[slice];
+
+        pool.Submit([begin, end]() {
+            std::sort(begin, end, LineLess);
+        });
+    }
+
+    pool.Wait();
+
+    auto less = [&](size_t a, size_t b) {
+        if (positions[a] == ends[a] || positions[b] == ends[b]) {
+            return positions[a] != ends[a] && positions[b] == ends[b];
+        }
+
+        return LineLess(lines[positions[a]], lines[positions[b]]);
+    };
+
+    LoserTree<decltype(less)> tree(slices, less);
+
+    while (positions[tree.Winner()] != ends[tree.Winner()]) {
+        size_t winner = tree.Winner();
+        const Line &line = lines[positions[winner]++];
+
+        writer.WriteLine(line.data, line.size);
+        tree.Replay(winner);
+    }
+}
+
+// A run being read in, or being sorted and written out.
+struct RunBuffer
+{
+    RunBuffer() :
+        data(nullptr),
+        filled(0),
+        written(false)
+    {}
+
+    PageBuffer buffer;
+    char *data;
+    size_t filled;
+    std::vector<Line> lines;
+    std::unique_ptr<Writer> writer;
+    bool written;
+};
+
+// Cut the input into sorted runs, one temporary file each.
+//
+// The memory is split between two run buffers. While one run is sorted and written out on
+// the pool, the next is read into the other, so the disk isn't idle while sorting.
+Reader::READ_STATUS WriteRuns(Reader & input, ThreadPool & pool, size_t memory_limit, MemoryBudget * budget,
+                              const std::string & directory, std::vector<std::string> & paths, size_t & runs) {
+    // Half of each buffer's share holds the run's bytes, the rest its line views.
+    const size_t share = memory_limit / 2;
+    const size_t max_lines = std::max<size_t>(1, (share - share / 2) / sizeof(Line));
+
+    MemoryReservation reserved(budget, memory_limit);
+    RunBuffer runs_buffers[2];
+
+    for (RunBuffer & run : runs_buffers) {
+        run.data = run.buffer.Reserve(std::max<size_t>(share / 2, 1));
+
+        if (run.data == nullptr) {
+            return Reader::READ_STATUS::ERROR;
+        }
+    }
+
+    Reader::READ_STATUS status = Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+    std::thread writing;
+    RunBuffer *current = &runs_buffers[0];
+    RunBuffer *other = &runs_buffers[1];
+    bool end_of_file = false;
+
+    // Wait for the run being written, returning whether it made it to disk.
+    auto finish_writing = [&writing, &other]() {
+        if (writing.joinable()) {
+            writing.join();
+        }
+
+        return other->written;
+    };
+
+    other->written = true;
+
+    while (true) {
+        RunBuffer &run = *current;
+
+        while (run.filled < run.buffer.Capacity() && !end_of_file) {
+            ssize_t bytes_read = 0;
+            Reader::READ_STATUS read_status = input.Read(run.data + run.filled, run.buffer.Capacity() - run.filled, &bytes_read);
+
+            if (input.StatusError(read_status)) {
+                status = read_status;
+                break;
+            }
+
+            run.filled += bytes_read;
+            end_of_file = input.StatusEndOfFile(read_status);
+        }
+
+        if (input.StatusError(status) || run.filled == 0) {
+            break;
+        }
+
+        run.lines.clear();
+        size_t start = 0;
+
+        while (start < run.filled && run.lines.size() < max_lines) {
+            const char *line = run.data + start;
+            const char *newline = static_cast<const char *>(memchr(line, '\n', run.filled - start));
+
+            if (newline == nullptr) {
+                // The final line may end without a newline, otherwise wait for the rest of it.
+                if (end_of_file) {
+                    run.lines.push_back(Line{Prefix(line, run.filled - start), line, run.filled - start});
+                    start = run.filled;
+                }
+
+                break;
+            }
+
+            run.lines.push_back(Line{Prefix(line, newline - line), line, static_cast<size_t>(newline - line)});
+            start = newline - run.data + 1;
+        }
+
+        // A single line larger than the buffer, grow it to fit.
+        if (run.lines.empty()) {
+            reserved.Resize(reserved.Bytes() + run.buffer.Capacity());
+            run.data = run.buffer.Reserve(run.buffer.Capacity() * 2);
+
+            if (run.data == nullptr) {
+                status = Reader::READ_STATUS::ERROR;
+                break;
+            }
+
+            continue;
+        }
+
+        // The other buffer is free once its run is on disk. The partial line at the end of
+        // this run starts the next one there.
+        if (!finish_writing()) {
+            status = Reader::READ_STATUS::ERROR;
+            break;
+        }
+
+        const size_t remainder = run.filled - start;
+
+        if (other->buffer.Capacity() < remainder) {
+            reserved.Resize(reserved.Bytes() + remainder - other->buffer.Capacity());
+            other->data = other->buffer.Reserve(remainder);
+
+            if (other->data == nullptr) {
+                status = Reader::READ_STATUS::ERROR;
+                break;
+            }
+        }
+
+        memcpy(other->data, run.data + start, remainder);
+        other->filled = remainder;
+
+        run.writer.reset(new Writer());
+        paths.push_back(std::string());
+
+        if (!run.writer->OpenTemporary(directory, paths.back())) {
+            paths.pop_back();
+            status = Reader::READ_STATUS::ERROR;
+            break;
+        }
+
+        runs++;
+        run.written = false;
+
+        writing = std::thread([&run, &pool]() {
+            WriteRun(run.lines, pool, *run.writer);
+            run.written = run.writer->Close();
+        });
+
+        std::swap(current, other);
+    }
+
+    if (!finish_writing()) {
+        status = Reader::READ_STATUS::ERROR;
+    }
+
+    return status;
+}
+
+} // End anonymous namespace
+
+ExternalSorter::ExternalSorter(size_t threads) :
+    threads(threads),
+    memory_limit(DEFAULT_MEMORY_LIMIT),
+    temp_directory("/tmp"),
+    merge_read_size(DEFAULT_MERGE_READ_SIZE),
+    budget(nullptr),
+    runs(0)
+{}
+
+ExternalSorter & ExternalSorter::SetMemoryLimit(size_t bytes) {
+    memory_limit = bytes > 0 ? bytes : DEFAULT_MEMORY_LIMIT;
+
+    return *this;
+}
+
+ExternalSorter & ExternalSorter::SetTempDirectory(const std::string & directory) {
+    temp_directory = directory;
+
+    return *this;
+}
+
+ExternalSorter & ExternalSorter::SetMergeReadSize(size_t size) {
+    merge_read_size = size > 0 ? size : DEFAULT_MERGE_READ_SIZE;
+
+    return *this;
+}
+
+ExternalSorter & ExternalSorter::SetMemoryBudget(MemoryBudget * shared_budget) {
+    budget = shared_budget;
+
+    return *this;
+}
+
+size_t ExternalSorter::Runs() const {
+    return runs;
+}
+
+Reader::READ_STATUS ExternalSorter::Sort(Reader & input, const std::string & output_path) {
+    ThreadPool pool(threads);
+    std::vector<std::string> paths;
+    size_t merged = 0;
+    runs = 0;
+
+    Reader::READ_STATUS status = WriteRuns(input, pool, memory_limit, budget, temp_directory, paths, runs);
+
+    // Merge as many runs at a time as there's memory for two blocks of each.
+    size_t fan_in = std::max<size_t>(2, memory_limit / (2 * merge_read_size));
+
+    while (!input.StatusError(status) && paths.size() - merged > fan_in) {
+        Writer writer;
+        std::string path;
+
+        if (!writer.OpenTemporary(temp_directory, path)) {
+            status = Reader::READ_STATUS::ERROR;
+            break;
+        }
+
+        paths.push_back(path);
+        status = MergeRuns(paths, merged, fan_in, writer, pool, merge_read_size, budget);
+        runs++;
+
+        if (!writer.Close()) {
+            status = Reader::READ_STATUS::ERROR;
+        }
+
+        for (size_t i = merged; i < merged + fan_in; i++) {
+            unlink(paths[i].c_str());
+        }
+
+        merged += fan_in;
+    }
+
+    if (!input.StatusError(status)) {
+        Writer writer;
+
+        if (writer.Open(output_path)) {
+            status = MergeRuns(paths, merged, paths.size() - merged, writer, pool, merge_read_size, budget);
+
+            if (!writer.Close()) {
+                status = Reader::READ_STATUS::ERROR;
+            }
+        } else {
+            status = Reader::READ_STATUS::ERROR;
+        }
+    }
+
+    for (size_t i = merged; i < paths.size(); i++) {
+        unlink(paths[i].c_str());
+    }
+
+    return status;
+}
+
+} // End File
@@ -0,0 +1,63 @@
+#ifndef FILE_EXTERNAL_SORT_H
+#define FILE_EXTERNAL_SORT_H
+
+#include <string>
+
+#include "file.hpp"
+
+namespace File
+{
+
+class MemoryBudget;
+
+// Sorts the lines of a file that doesn't fit in memory, bytewise like LC_ALL=C sort.
+//
+// The input is read in runs that fill half the memory limit. Each run's lines are sorted as
+// views into the run buffer, in slices on every thread, then merged and written out
+// sequentially to a temporary file, while the next run is read into the other half.
+//
+// The runs are then merged with a loser tree, each run read through its own reader that
+// prefetches the next block on the pool while the current one is merged. When there are more
+// runs than fit in memory at once, they are merged in several passes.
+//
+// Every output line ends with '\n', including the last one if the input's didn't.
+class ExternalSorter
+{
+public:
+  // Zero threads means one per hardware thread.
+  explicit ExternalSorter(size_t threads = 0);
+
+  // Memory used for the two runs in flight, including their line views, and for the merge
+  // buffers. Zero means the default of 256 MiB.
+  ExternalSorter &SetMemoryLimit(size_t bytes);
+
+  // Where run files are written, /tmp by default. They are removed once merged.
+  ExternalSorter &SetTempDirectory(const std::string &directory);
+
+  // Block size each run is read in while merging. Two blocks per run are kept in memory.
+  // Zero means the default of 1 MiB.
+  ExternalSorter &SetMergeReadSize(size_t size);
+
+  // Count the run buffers, and each merge's blocks, against a budget shared with other
+  // stages. The sort waits for room before cutting runs and before each merge. The memory
+  // limit still decides how much it uses.
+  ExternalSorter &SetMemoryBudget(MemoryBudget *budget);
+
+  // Sort the input's lines into the file at output_path, replacing it.
+  Reader::READ_STATUS Sort(Reader &input, const std::string &output_path);
+
+  // Runs written by the last sort, counting those of intermediate merge passes.
+  size_t Runs() const;
+
+private:
+  size_t threads;
+  size_t memory_limit;
+  std::string temp_directory;
+  size_t merge_read_size;
+  MemoryBudget *budget;
+  size_t runs;
+};
+
+} // End File
+
+#endif // FILE_EXTERNAL_SORT_H
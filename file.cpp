@@ -1,8 +1,12 @@
 #include "file.hpp"
+#include "block_cache.hpp"
 
 #include <string.h>
 #include <errno.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 
@@ -24,73 +28,196 @@ bool StatusTypeError(STATUS status) {
 }
 
 Reader::Reader() :
-    descriptor(0),
-    read_size(0)
+    descriptor(-1),
+    read_size(0),
+    block_cache(nullptr),
+    non_blocking_reads(true),
+    position(0)
 {}
 
-File::STATUS Reader::Open(const char * path) {
-    if (access(path, F_OK) == -1) {
+namespace {
+
+// Flags for every open. O_NOATIME spares the inode an update (and writeback) on every read,
+// O_NONBLOCK keeps a FIFO from blocking the open before initialize() gets to reject it, and
+// is cleared once the file is known to be regular.
+const int OPEN_FLAGS = O_RDONLY | O_CLOEXEC | O_NONBLOCK | O_NOATIME;
+
+// Whether two stats of a file describe the same contents, as far as the block cache can tell.
+bool SameVersion(const struct stat & a, const struct stat & b) {
+    return a.st_size == b.st_size && a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+STATUS OpenStatus() {
+    if (errno == ENOENT || errno == EACCES || errno == EPERM) {
         return File::STATUS::ERROR | File::STATUS::INSUFFICIENT_ACCESS;
     }
 
-    if ( stat(path, &(file_stat)) == -1 ) {
+    return File::STATUS::ERROR;
+}
+
+} // End anonymous namespace
+
+File::STATUS Reader::Open(const char * path) {
+    Close();
+
+    // O_NOATIME is refused for files we don't own, so try again without it.
+    if ( (descriptor = open(path, OPEN_FLAGS)) == -1 && errno == EPERM ) {
+        descriptor = open(path, OPEN_FLAGS & ~O_NOATIME);
+    }
+
+    if (descriptor == -1) {
+        return OpenStatus();
+    }
+
+    return initialize();
+}
+
+File::STATUS Reader::OpenAt(int directory, const char * name) {
+    Close();
+
+    if ( (descriptor = openat(directory, name, OPEN_FLAGS)) == -1 && errno == EPERM ) {
+        descriptor = openat(directory, name, OPEN_FLAGS & ~O_NOATIME);
+    }
+
+    if (descriptor == -1) {
+        return OpenStatus();
+    }
+
+    return initialize();
+}
+
+File::STATUS Reader::initialize() {
+    // Checking the opened descriptor rather than the path leaves no window for the file to
+    // be swapped in between, and saves the access() and stat() calls.
+    if ( fstat(descriptor, &(file_stat)) == -1 ) {
+        Close();
         return File::STATUS::ERROR;
     }
 
     // Make sure this is a regular file. For now, that's all that is supported.
     if (!S_ISREG(file_stat.st_mode)) {
+        Close();
         return File::STATUS::ERROR | File::STATUS::INVALID_TYPE;
     }
 
-    if ( (descriptor = open(path, O_RDONLY)) == -1 ) {
+    // O_NONBLOCK was only for the open. Left set, it changes how reads behave on NFS and FUSE
+    // and with mandatory locks.
+    int flags = fcntl(descriptor, F_GETFL);
+
+    if ( flags == -1 || fcntl(descriptor, F_SETFL, flags & ~O_NONBLOCK) == -1 ) {
+        Close();
         return File::STATUS::ERROR;
     }
 
     // Set the default read size to the optimum IO blocksize.
     read_size = file_stat.st_blksize;
+    position = 0;
 
-    // Advise the kernel that we intend to perform sequential reads.
-    posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+    // Advise the kernel that we intend to perform sequential reads. Files that fit in a
+    // single read gain nothing from readahead, so skip the syscall for them.
+    if (file_stat.st_size > file_stat.st_blksize) {
+        posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
 
     return File::STATUS::OK;
 }
 
+void Reader::Close() {
+    if (descriptor != -1) {
+        if (close(descriptor) == -1) {
+            std::cerr << "Failed to close file\n";
+        }
+
+        descriptor = -1;
+    }
+}
+
 File::STATUS Reader::Open(const std::string & path) {
     return Open(path.c_str());
 }
 
+File::STATUS Reader::OpenAt(int directory, const std::string & name) {
+    return OpenAt(directory, name.c_str());
+}
+
 Reader& Reader::SetReadSize(size_t size) {
     read_size = size;
 
     return *this;
 }
 
-Reader::~Reader() {
-  if (descriptor != 0) {
-    if (close(descriptor) == -1) {
-        std::cerr << "Failed to close file\n";
+Reader& Reader::SetNonBlockingReads(bool enabled) {
+    non_blocking_reads = enabled;
+
+    return *this;
+}
+
+Reader& Reader::SetHugePages(bool enabled) {
+    buffer.SetHugePages(enabled);
+
+    return *this;
+}
+
+Reader& Reader::SetAllocator(const BufferAllocator & allocator) {
+    buffer.SetAllocator(allocator);
+
+    return *this;
+}
+
+Reader& Reader::SetBlockCache(BlockCache * cache) {
+    if (descriptor != -1) {
+        if (!block_cache && cache) {
+            position = lseek(descriptor, 0, SEEK_CUR);
+        } else if (block_cache && !cache) {
+            lseek(descriptor, position, SEEK_SET);
+        }
     }
-  }
+
+    block_cache = cache;
+
+    return *this;
+}
+
+int Reader::Descriptor() const {
+    return descriptor;
+}
+
+const struct stat & Reader::Stat() const {
+    return file_stat;
 }
 
-Reader::READ_STATUS Reader::Read(std::string & buffer) {
-    char *buf = new (std::nothrow) char[read_size + 1];
-    auto mananged_buffer = std::unique_ptr<char[]>(buf);
+size_t Reader::ReadSize() const {
+    return read_size;
+}
+
+Reader::~Reader() {
+  Close();
+}
+
+Reader::READ_STATUS Reader::Read(std::string & output) {
+    char *buf = ReserveBuffer(read_size);
+
+    if (buf == nullptr) {
+        return READ_STATUS::ERROR;
+    }
 
     ssize_t bytes_read = 0;
 
     READ_STATUS status = Read(buf, read_size, &bytes_read);
 
     if ( status != READ_STATUS::ERROR ) {
-        buffer.clear();
-
-        // Copy buf into buffer.
-        buffer.assign(buf, bytes_read);
+        // Copy buf into output.
+        output.assign(buf, bytes_read);
     }
 
     return status;
 }
 
+char * Reader::ReserveBuffer(size_t size) {
+    // Always hand out a buffer, even for a zero byte read.
+    return buffer.Reserve(size > 0 ? size : 1);
+}
+
 Reader::READ_STATUS Reader::Read(std::function<void(std::string & buffer)> callback) {
     std::string buf;
 
@@ -108,13 +235,533 @@ Reader::READ_STATUS Reader::Read(std::function<void(std::string & buffer)> callb
     return status;
 }
 
-Reader::READ_STATUS Reader::ReadAll(std::string & buffer) {
+Reader::READ_STATUS Reader::ReadAll(std::string & output) {
     read_size = file_stat.st_size;
 
-    return Read(buffer);
+    // Read straight into the output, a file sized scratch buffer would outlive the call.
+    std::string contents(read_size, '\0');
+    ssize_t bytes_read = 0;
+
+    READ_STATUS status = Read(&contents[0], read_size, &bytes_read);
+
+    if ( status != READ_STATUS::ERROR ) {
+        contents.resize(bytes_read);
+        output.swap(contents);
+    }
+
+    return status;
+}
+
+Reader::READ_STATUS Reader::ReadSparse(std::function<void(off_t, std::string &)> callback,
+                                       std::function<void(off_t, off_t)> hole_callback) {
+    // The file may have grown or shrunk since it was opened.
+    if (fstat(descriptor, &file_stat) == -1) {
+        return READ_STATUS::ERROR;
+    }
+
+    char *buf = ReserveBuffer(read_size);
+
+    if (buf == nullptr) {
+        return READ_STATUS::ERROR;
+    }
+
+    const off_t end = file_stat.st_size;
+    off_t offset = 0;
+    std::string chunk;
+
+    while (offset < end) {
+        off_t data = lseek(descriptor, offset, SEEK_DATA);
+
+        if (data == -1) {
+            if (errno == ENXIO) {
+                // No data past offset, the remainder of the file is a hole.
+                data = end;
+            } else if (errno == EINVAL) {
+                // The filesystem doesn't support SEEK_DATA, treat everything as data.
+                data = offset;
+            } else {
+                return READ_STATUS::ERROR;
+            }
+        }
+
+        if (data > end) {
+            data = end;
+        }
+
+        if (data > offset) {
+            hole_callback(offset, data - offset);
+            offset = data;
+
+            if (offset >= end) {
+                break;
+            }
+        }
+
+        off_t hole = lseek(descriptor, offset, SEEK_HOLE);
+
+        if (hole == -1) {
+            if (errno != EINVAL) {
+                return READ_STATUS::ERROR;
+            }
+
+            hole = end;
+        }
+
+        if (hole > end) {
+            hole = end;
+        }
+
+        if (lseek(descriptor, offset, SEEK_SET) == -1) {
+            return READ_STATUS::ERROR;
+        }
+
+        position = offset;
+
+        while (offset < hole) {
+            size_t remaining = static_cast<size_t>(hole - offset);
+            ssize_t bytes_read = 0;
+
+            READ_STATUS status = Read(buf, read_size < remaining ? read_size : remaining, &bytes_read);
+
+            if (StatusError(status)) {
+                return status;
+            }
+
+            // The file was truncated underneath us.
+            if (bytes_read == 0) {
+                return READ_STATUS::OK | READ_STATUS::END_OF_FILE;
+            }
+
+            chunk.assign(buf, bytes_read);
+            callback(offset, chunk);
+
+            offset += bytes_read;
+        }
+    }
+
+    return READ_STATUS::OK | READ_STATUS::END_OF_FILE;
+}
+
+Reader::READ_STATUS Reader::ReadReverse(std::function<void(std::string &)> callback) {
+    return ReadReverseUntil([&callback](std::string & chunk) {
+        callback(chunk);
+
+        return true;
+    });
+}
+
+Reader::READ_STATUS Reader::ReadReverseUntil(std::function<bool(std::string &)> callback) {
+    if (fstat(descriptor, &file_stat) == -1) {
+        return READ_STATUS::ERROR;
+    }
+
+    if (read_size == 0) {
+        return READ_STATUS::ERROR;
+    }
+
+    char *buf = ReserveBuffer(read_size);
+
+    if (buf == nullptr) {
+        return READ_STATUS::ERROR;
+    }
+
+    // Kernel readahead only works forwards, so we do our own one chunk ahead.
+    posix_fadvise(descriptor, 0, 0, POSIX_FADV_RANDOM);
+
+    off_t end = file_stat.st_size;
+    std::string chunk;
+    READ_STATUS status = READ_STATUS::OK | READ_STATUS::END_OF_FILE;
+
+    while (end > 0) {
+        // The first chunk takes the remainder so that every following chunk is aligned.
+        size_t chunk_size = end % read_size;
+
+        if (chunk_size == 0) {
+            chunk_size = read_size;
+        }
+
+        off_t start = end - chunk_size;
+
+        if (start > 0) {
+            off_t previous = start < (off_t) read_size ? 0 : start - read_size;
+            posix_fadvise(descriptor, previous, start - previous, POSIX_FADV_WILLNEED);
+        }
+
+        ssize_t bytes_read = 0;
+        status = ReadAt(buf, chunk_size, start, &bytes_read);
+
+        if (StatusError(status)) {
+            break;
+        }
+
+        chunk.assign(buf, bytes_read);
+        end = start;
+        status = READ_STATUS::OK | READ_STATUS::END_OF_FILE;
+
+        if (!callback(chunk)) {
+            status = READ_STATUS::OK;
+            break;
+        }
+    }
+
+    posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    return status;
+}
+
+Reader::READ_STATUS Reader::ReadLinesReverse(std::function<bool(const View &)> callback) {
+    // The unfinished first line of the chunks read so far, last piece first. They're only
+    // joined once its start is found, so a line spanning many chunks is copied once.
+    std::vector<std::string> pieces;
+    std::string line;
+    bool first_chunk = true;
+
+    auto join = [&pieces, &line](const char *begin, const char *end) {
+        line.assign(begin, end - begin);
+
+        for (auto piece = pieces.rbegin(); piece != pieces.rend(); ++piece) {
+            line.append(*piece);
+        }
+
+        pieces.clear();
+    };
+
+    READ_STATUS status = ReadReverseUntil([&](std::string & chunk) {
+        const char *begin = chunk.data();
+        const char *end = begin + chunk.size();
+
+        // A trailing newline terminates the last line, it doesn't start an empty one.
+        if (first_chunk && end != begin && *(end - 1) == '\n') {
+            --end;
+        }
+
+        first_chunk = false;
+
+        const char *newline;
+
+        while ((newline = static_cast<const char *>(memrchr(begin, '\n', end - begin))) != nullptr) {
+            bool more;
+
+            if (pieces.empty()) {
+                more = callback(View(newline + 1, end - newline - 1));
+            } else {
+                join(newline + 1, end);
+                more = callback(View(line));
+            }
+
+            if (!more) {
+                return false;
+            }
+
+            end = newline;
+        }
+
+        pieces.emplace_back(begin, end - begin);
+
+        return true;
+    });
+
+    if (StatusError(status) || !StatusEndOfFile(status)) {
+        return status;
+    }
+
+    // Whatever is left is the first line of the file.
+    if (!first_chunk) {
+        join(nullptr, nullptr);
+        callback(View(line));
+    }
+
+    return status;
+}
+
+Reader::READ_STATUS Reader::TryRead(char * buffer, size_t bytes_to_read, ssize_t * bytes_read) {
+    // The block cache keeps its own offset, elsewhere preadv2 at -1 uses the file offset.
+    READ_STATUS status = TryReadAt(buffer, bytes_to_read, block_cache ? position : -1, bytes_read);
+
+    if (block_cache) {
+        position += *bytes_read;
+    }
+
+    return status;
+}
+
+Reader::READ_STATUS Reader::TryRead(std::string & output) {
+    char *buf = ReserveBuffer(read_size);
+
+    if (buf == nullptr) {
+        return READ_STATUS::ERROR;
+    }
+
+    ssize_t bytes_read = 0;
+    READ_STATUS status = TryRead(buf, read_size, &bytes_read);
+
+    if (!StatusError(status) && !StatusWouldBlock(status)) {
+        output.assign(buf, bytes_read);
+    }
+
+    return status;
+}
+
+Reader::READ_STATUS Reader::TryReadAt(char * buffer, size_t bytes_to_read, off_t offset, ssize_t * bytes_read) {
+    *bytes_read = 0;
+
+    if (!non_blocking_reads) {
+        return READ_STATUS::WOULD_BLOCK;
+    }
+
+    if ( flock(descriptor, LOCK_EX | LOCK_NB) == -1 ) {
+        return READ_STATUS::ERROR;
+    }
+
+    ssize_t num_bytes_read = 0;
+
+    do {
+        struct iovec vector = { buffer, bytes_to_read };
+
+        num_bytes_read = preadv2(descriptor, &vector, 1, offset, RWF_NOWAIT);
+
+        if (num_bytes_read <= 0) {
+            break;
+        }
+
+        *bytes_read += num_bytes_read;
+        buffer += num_bytes_read;
+        bytes_to_read -= num_bytes_read;
+
+        if (offset != -1) {
+            offset += num_bytes_read;
+        }
+    } while (bytes_to_read > 0);
+
+    int error = errno;
+
+    if ( flock(descriptor, LOCK_UN | LOCK_NB) == -1 ) {
+        return READ_STATUS::ERROR;
+    }
+
+    if (num_bytes_read == -1) {
+        // Kernels or filesystems without RWF_NOWAIT can't promise not to block either.
+        if (error == EAGAIN || error == EOPNOTSUPP || error == ENOSYS) {
+            return *bytes_read > 0 ? READ_STATUS::OK : READ_STATUS::WOULD_BLOCK;
+        }
+
+        return READ_STATUS::ERROR;
+    }
+
+    return num_bytes_read == 0 ? READ_STATUS::OK | READ_STATUS::END_OF_FILE : READ_STATUS::OK;
+}
+
+Reader::READ_STATUS Reader::Residency(off_t offset, size_t length, std::vector<bool> & resident) {
+    resident.clear();
+
+    if (length == 0) {
+        return READ_STATUS::OK;
+    }
+
+    const off_t page_size = sysconf(_SC_PAGESIZE);
+    const off_t start = offset - offset % page_size;
+    const size_t mapped = length + static_cast<size_t>(offset - start);
+
+    void *mapping = mmap(nullptr, mapped, PROT_READ, MAP_SHARED, descriptor, start);
+
+    if (mapping == MAP_FAILED) {
+        return READ_STATUS::ERROR;
+    }
+
+    std::vector<unsigned char> pages((mapped + page_size - 1) / page_size);
+    int result = mincore(mapping, mapped, pages.data());
+
+    munmap(mapping, mapped);
+
+    if (result == -1) {
+        return READ_STATUS::ERROR;
+    }
+
+    resident.reserve(pages.size());
+
+    for (unsigned char page : pages) {
+        resident.push_back((page & 1) != 0);
+    }
+
+    return READ_STATUS::OK;
+}
+
+Reader::READ_STATUS Reader::ReadCachedFirst(std::function<void(off_t, std::string &)> callback) {
+    const off_t size = file_stat.st_size;
+    const off_t page_size = sysconf(_SC_PAGESIZE);
+
+    // Whole pages per chunk, so residency maps onto chunks exactly.
+    off_t chunk_size = read_size > 0 ? static_cast<off_t>(read_size) : file_stat.st_blksize;
+    chunk_size = (chunk_size + page_size - 1) / page_size * page_size;
+
+    char *buf = ReserveBuffer(chunk_size);
+
+    if (buf == nullptr) {
+        return READ_STATUS::ERROR;
+    }
+
+    std::vector<bool> resident;
+    READ_STATUS status = Residency(0, size, resident);
+
+    if (StatusError(status)) {
+        return status;
+    }
+
+    std::string chunk;
+
+    auto read_chunk = [&](off_t offset) {
+        ssize_t bytes_read = 0;
+        size_t length = size - offset < chunk_size ? size - offset : chunk_size;
+
+        READ_STATUS read_status = ReadAt(buf, length, offset, &bytes_read);
+
+        if (!StatusError(read_status) && bytes_read > 0) {
+            chunk.assign(buf, bytes_read);
+            callback(offset, chunk);
+        }
+
+        return read_status;
+    };
+
+    std::vector<off_t> cold;
+    const size_t pages_per_chunk = chunk_size / page_size;
+
+    // Only the next few cold chunks are fetched ahead. Asking for the whole of a cold file
+    // larger than memory would evict the early chunks before they're read, along with the
+    // cached ones.
+    const size_t lookahead = 64;
+
+    for (off_t offset = 0; offset < size; offset += chunk_size) {
+        size_t first = offset / page_size;
+        size_t last = first + pages_per_chunk < resident.size() ? first + pages_per_chunk : resident.size();
+
+        if (std::find(resident.begin() + first, resident.begin() + last, false) != resident.begin() + last) {
+            // Start the fetch now, it completes while the cached chunks are processed.
+            if (cold.size() < lookahead) {
+                posix_fadvise(descriptor, offset, chunk_size, POSIX_FADV_WILLNEED);
+            }
+
+            cold.push_back(offset);
+            continue;
+        }
+
+        status = read_chunk(offset);
+
+        if (StatusError(status)) {
+            return status;
+        }
+    }
+
+    // Cold chunks, a window at a time: whichever have arrived are read first, and if none
+    // have, the oldest is waited for.
+    std::vector<bool> done(cold.size(), false);
+    size_t next = 0;
+    size_t advised = cold.size() < lookahead ? cold.size() : lookahead;
+
+    while (next < cold.size()) {
+        size_t end = next + lookahead < cold.size() ? next + lookahead : cold.size();
+
+        // Keep the fetch running ahead as the window slides.
+        for (; advised < end; advised++) {
+            posix_fadvise(descriptor, cold[advised], chunk_size, POSIX_FADV_WILLNEED);
+        }
+
+        // One probe covers the whole window.
+        const off_t window_start = cold[next];
+        const off_t window_end = cold[end - 1] + chunk_size < size ? cold[end - 1] + chunk_size : size;
+
+        if (StatusError(Residency(window_start, window_end - window_start, resident))) {
+            resident.clear();
+        }
+
+        bool arrived = false;
+
+        for (size_t i = next; i < end; i++) {
+            size_t first = (cold[i] - window_start) / page_size;
+
+            if (done[i] || first >= resident.size()) {
+                continue;
+            }
+
+            size_t last = first + pages_per_chunk < resident.size() ? first + pages_per_chunk : resident.size();
+
+            if (std::find(resident.begin() + first, resident.begin() + last, false) != resident.begin() + last) {
+                continue;
+            }
+
+            status = read_chunk(cold[i]);
+
+            if (StatusError(status)) {
+                return status;
+            }
+
+            done[i] = true;
+            arrived = true;
+        }
+
+        if (!arrived) {
+            status = read_chunk(cold[next]);
+
+            if (StatusError(status)) {
+                return status;
+            }
+
+            done[next] = true;
+        }
+
+        while (next < cold.size() && done[next]) {
+            next++;
+        }
+    }
+
+    return READ_STATUS::OK | READ_STATUS::END_OF_FILE;
+}
+
+Reader::READ_STATUS Reader::ReadAt(char * buffer, size_t bytes_to_read, off_t offset, ssize_t * bytes_read) {
+    *bytes_read = 0;
+
+    if ( flock(descriptor, LOCK_EX | LOCK_NB) == -1 ) {
+        return READ_STATUS::ERROR;
+    }
+
+    ssize_t num_bytes_read = 0;
+
+    do {
+        num_bytes_read = pread(descriptor, (void *) buffer, bytes_to_read, offset);
+
+        if (num_bytes_read <= 0) {
+            break;
+        }
+
+        *bytes_read += num_bytes_read;
+        buffer += num_bytes_read;
+        offset += num_bytes_read;
+        bytes_to_read -= num_bytes_read;
+    } while (bytes_to_read > 0);
+
+    if ( flock(descriptor, LOCK_UN | LOCK_NB) == -1 ) {
+        return READ_STATUS::ERROR;
+    }
+
+    READ_STATUS ret = READ_STATUS::OK;
+
+    switch (num_bytes_read) {
+        case -1:
+            ret = READ_STATUS::ERROR;
+            break;
+        case 0:
+            ret |= READ_STATUS::END_OF_FILE;
+            break;
+    }
+
+    return ret;
 }
 
 Reader::READ_STATUS Reader::Read(char * buffer, size_t bytes_to_read, ssize_t * bytes_read) {
+    if (block_cache) {
+        return ReadCached(buffer, bytes_to_read, bytes_read);
+    }
+
     *bytes_read = 0;
 
     if ( flock(descriptor, LOCK_EX | LOCK_NB) == -1 ) {
@@ -158,16 +805,100 @@ Reader::READ_STATUS Reader::Read(char * buffer, size_t bytes_to_read, ssize_t *
     return ret;
 }
 
+Reader::READ_STATUS Reader::ReadCached(char * buffer, size_t bytes_to_read, ssize_t * bytes_read) {
+    *bytes_read = 0;
+
+    // Blocks are only valid for the file's current size and mtime, which may have changed
+    // since it was opened or last read.
+    if ( fstat(descriptor, &file_stat) == -1 ) {
+        return READ_STATUS::ERROR;
+    }
+
+    const size_t block_size = block_cache->BlockSize();
+
+    while (bytes_to_read > 0) {
+        uint64_t block = static_cast<uint64_t>(position) / block_size;
+        size_t within = static_cast<size_t>(position) % block_size;
+
+        BlockCache::Block data = block_cache->Get(file_stat, block);
+
+        // Load the whole block on a miss, so the next reader of this range hits.
+        if (!data) {
+            std::shared_ptr<std::string> loaded = std::make_shared<std::string>(block_size, '\0');
+            ssize_t loaded_bytes = 0;
+
+            READ_STATUS status = ReadAt(&(*loaded)[0], block_size, static_cast<off_t>(block * block_size), &loaded_bytes);
+
+            if (StatusError(status)) {
+                return status;
+            }
+
+            loaded->resize(loaded_bytes);
+
+            // Only share the block if the file didn't change while it was read, and key it on
+            // the file as it is now.
+            struct stat current;
+
+            if ( fstat(descriptor, &current) == -1 ) {
+                return READ_STATUS::ERROR;
+            }
+
+            if (SameVersion(current, file_stat)) {
+                block_cache->Put(file_stat, block, loaded);
+            }
+
+            file_stat = current;
+            data = loaded;
+        }
+
+        // Only the last block is short, so there's nothing past it.
+        if (within >= data->size()) {
+            return READ_STATUS::OK | READ_STATUS::END_OF_FILE;
+        }
+
+        size_t count = data->size() - within < bytes_to_read ? data->size() - within : bytes_to_read;
+
+        memcpy(buffer, data->data() + within, count);
+
+        buffer += count;
+        bytes_to_read -= count;
+        position += count;
+        *bytes_read += count;
+    }
+
+    return READ_STATUS::OK;
+}
+
 bool Reader::StatusOk(READ_STATUS status) {
-    return (status & READ_STATUS::OK) == READ_STATUS::OK;
+    return File::StatusOk(status);
 }
 
 bool Reader::StatusError(READ_STATUS status) {
-    return (status & READ_STATUS::ERROR) == READ_STATUS::ERROR;
+    return File::StatusError(status);
+}
+
+bool Reader::StatusWouldBlock(READ_STATUS status) {
+    return File::StatusWouldBlock(status);
 }
 
 bool Reader::StatusEndOfFile(READ_STATUS status) {
-    return (status & READ_STATUS::END_OF_FILE) == READ_STATUS::END_OF_FILE;
+    return File::StatusEndOfFile(status);
+}
+
+bool StatusOk(Reader::READ_STATUS status) {
+    return (status & Reader::READ_STATUS::OK) == Reader::READ_STATUS::OK;
+}
+
+bool StatusError(Reader::READ_STATUS status) {
+    return (status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR;
+}
+
+bool StatusWouldBlock(Reader::READ_STATUS status) {
+    return (status & Reader::READ_STATUS::WOULD_BLOCK) == Reader::READ_STATUS::WOULD_BLOCK;
+}
+
+bool StatusEndOfFile(Reader::READ_STATUS status) {
+    return (status & Reader::READ_STATUS::END_OF_FILE) == Reader::READ_STATUS::END_OF_FILE;
 }
 
 } // End File
\ No newline at end of file
@@ -7,12 +7,20 @@
 #include <unistd.h>
 #include <string>
 #include <functional>
+#include <vector>
 
 #include "enums.hpp"
+#include "page_buffer.hpp"
+#include "view.hpp"
 
 namespace File
 {
 
+class BlockCache;
+class BufferAllocator;
+class ChunkRange;
+class LineRange;
+
 enum class STATUS : char
 {
   OK = 1,
@@ -39,7 +47,10 @@ public:
 
     // Specific errors.
     END_OF_FILE = 1 << 3,
-    COULD_NOT_LOCK = 1 << 4
+    COULD_NOT_LOCK = 1 << 4,
+
+    // TryRead found nothing cached to return without blocking.
+    WOULD_BLOCK = 1 << 5
   };
 
   Reader();
@@ -54,25 +65,119 @@ public:
   // Read the entire file into the internal buffer, using the optimal block size.
   READ_STATUS ReadAll(std::string &buffer);
 
+  // Read only the data regions of a (possibly sparse) file, using SEEK_DATA/SEEK_HOLE.
+  // Data chunks are passed along with their file offset, holes are reported as
+  // (offset, length) zero runs and never materialized.
+  READ_STATUS ReadSparse(std::function<void(off_t, std::string &)> callback,
+                         std::function<void(off_t, off_t)> hole_callback);
+
+  // Read chunks from the end of the file towards the beginning.
+  READ_STATUS ReadReverse(std::function<void(std::string &)> callback);
+
+  // Read lines from last to first. Returning false from the callback stops the read,
+  // so reading the last N lines only costs the size of those lines.
+  READ_STATUS ReadLinesReverse(std::function<bool(const View &)> callback);
+
+  // Read bytes_to_read into a caller owned buffer, returning *bytes_read as the actual byte count.
+  READ_STATUS Read(char *buffer, size_t bytes_to_read, ssize_t *bytes_read);
+
+  // Read bytes_to_read starting at offset, without moving the file offset.
+  READ_STATUS ReadAt(char *buffer, size_t bytes_to_read, off_t offset, ssize_t *bytes_read);
+
+  // Like Read, but only returns data already in the page cache, using preadv2 with
+  // RWF_NOWAIT. Returns WOULD_BLOCK if nothing could be read without waiting on the disk, so
+  // the caller can hand the read to an I/O thread instead. The data returned may be short
+  // of bytes_to_read when only part of it is cached.
+  READ_STATUS TryRead(char *buffer, size_t bytes_to_read, ssize_t *bytes_read);
+  READ_STATUS TryRead(std::string &buffer);
+  READ_STATUS TryReadAt(char *buffer, size_t bytes_to_read, off_t offset, ssize_t *bytes_read);
+
+  // Disabled, TryRead always returns WOULD_BLOCK without reading, so an AsyncReader hands
+  // every read to its pool. For filesystems where RWF_NOWAIT can't be trusted not to block,
+  // and to exercise the blocking path whatever the page cache holds. Enabled by default.
+  Reader &SetNonBlockingReads(bool enabled);
+
+  // Which pages of [offset, offset + length) are in the page cache, one entry per page
+  // starting with the page holding offset. Uses mincore on a mapping that is never touched.
+  READ_STATUS Residency(off_t offset, size_t length, std::vector<bool> &resident);
+
+  // Read every chunk once, in no particular order: chunks already in the page cache first,
+  // while the kernel is asked to fetch the next few cold ones, then the cold ones, a sliding
+  // window at a time, preferring those that have arrived. For order insensitive work like
+  // sums and counts, this hides most of the wait on cold regions. Chunks are passed along
+  // with their file offset.
+  READ_STATUS ReadCachedFirst(std::function<void(off_t, std::string &)> callback);
+
   Reader &SetReadSize(size_t size);
 
+  // Serve sequential reads from a block cache shared with other readers, e.g.
+  // BlockCache::Global(). Passing nullptr goes back to reading straight from the file.
+  Reader &SetBlockCache(BlockCache *cache);
+
+  // Back the reader's buffer with 2 MiB pages once it grows to one, for multi megabyte
+  // read sizes. See PageBuffer.
+  Reader &SetHugePages(bool enabled);
+
+  // Where the reader's buffer comes from, BufferAllocator::Pooled() by default.
+  Reader &SetAllocator(const BufferAllocator &allocator);
+
+  // The open descriptor, the file's stat and the read size, for readers layered on top of
+  // this one.
+  int Descriptor() const;
+  const struct stat &Stat() const;
+  size_t ReadSize() const;
+
   File::STATUS Open(const char *path);
   File::STATUS Open(const std::string &path);
 
+  // Open a file relative to an open directory, avoiding a full path lookup per file when
+  // scanning a directory.
+  File::STATUS OpenAt(int directory, const char *name);
+  File::STATUS OpenAt(int directory, const std::string &name);
+
+  // Close the file, which also happens on destruction or when opening another one.
+  void Close();
+
   bool StatusOk(READ_STATUS status);
   bool StatusEndOfFile(READ_STATUS status);
   bool StatusError(READ_STATUS status);
+  bool StatusWouldBlock(READ_STATUS status);
 private:
   int descriptor;
   struct stat file_stat;
   size_t read_size;
 
+  BlockCache *block_cache;
+  bool non_blocking_reads;
+
+  // Scratch buffer reused by every Read(std::string &) and by the ranges, which hand out
+  // views into it instead of copying.
+  PageBuffer buffer;
+
+  // The read offset while reading through the block cache, which never moves the file offset.
+  off_t position;
+
   File::STATUS initialize();
 
-  // Read bytes_to_read into buffer, returning *bytes_read as the actual byte count.
-  READ_STATUS Read(char *buffer, size_t bytes_to_read, ssize_t *bytes_read);
+  // Grow the scratch buffer to at least size bytes, keeping its contents. Returns nullptr
+  // if it can't.
+  char *ReserveBuffer(size_t size);
+
+  READ_STATUS ReadCached(char *buffer, size_t bytes_to_read, ssize_t *bytes_read);
+
+  // Read chunks backwards until the callback returns false.
+  READ_STATUS ReadReverseUntil(std::function<bool(std::string &)> callback);
+
+  friend class ChunkRange;
+  friend class LineRange;
 };
 
+// The read status checks, for when there's no reader at hand.
+bool StatusOk(Reader::READ_STATUS status);
+bool StatusEndOfFile(Reader::READ_STATUS status);
+bool StatusError(Reader::READ_STATUS status);
+bool StatusWouldBlock(Reader::READ_STATUS status);
+
 } // End File
 
 #endif // FILE_READER_H
@@ -0,0 +1,395 @@
+#include "framed_reader.hpp"
+#include "memory_budget.hpp"
+#include "search.hpp"
+#include "thread_pool.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace File {
+
+namespace {
+
+const size_t DEFAULT_BUFFER_SIZE = 1 << 16;
+const size_t DEFAULT_MAX_RECORD_SIZE = 1 << 30;
+const size_t MAX_VARINT_SIZE = 10;
+
+// ParallelRead cuts the file into this many ranges per worker, but no smaller than
+// MIN_RANGE_SIZE.
+const size_t RANGES_PER_WORKER = 16;
+const size_t MIN_RANGE_SIZE = 1 << 16;
+
+typedef std::function<Reader::READ_STATUS(char *, size_t, ssize_t *)> Source;
+
+// A sliding window over a byte source, which only ever moves or grows to fit a whole frame.
+// With a budget, the window's capacity counts against it.
+class FrameBuffer
+{
+public:
+  FrameBuffer(Source source, size_t capacity, off_t offset, MemoryBudget *budget = nullptr) :
+    source(source),
+    reserved(budget, capacity),
+    buffer(new (std::nothrow) char[capacity]),
+    capacity(buffer ? capacity : 0),
+    start(0),
+    end(0),
+    offset(offset),
+    end_of_file(false)
+  {}
+
+  // Try to make size bytes available, fewer may be once the source is exhausted.
+  Reader::READ_STATUS Fill(size_t size)
+  {
+    if (Available() >= size || end_of_file) {
+      return Reader::READ_STATUS::OK;
+    }
+
+    if (size > capacity) {
+      size_t grown = capacity * 2 > size ? capacity * 2 : size;
+      reserved.Resize(capacity + grown);
+
+      char *larger = new (std::nothrow) char[grown];
+
+      if (larger == nullptr) {
+        return Reader::READ_STATUS::ERROR;
+      }
+
+      memcpy(larger, buffer.get() + start, Available());
+      buffer.reset(larger);
+      capacity = grown;
+      reserved.Resize(capacity);
+      end -= start;
+      start = 0;
+    } else if (start + size > capacity) {
+      memmove(buffer.get(), buffer.get() + start, Available());
+      end -= start;
+      start = 0;
+    }
+
+    while (Available() < size) {
+      ssize_t bytes_read = 0;
+      Reader::READ_STATUS status = source(buffer.get() + end, capacity - end, &bytes_read);
+
+      if ((status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR) {
+        return status;
+      }
+
+      end += bytes_read;
+
+      if ((status & Reader::READ_STATUS::END_OF_FILE) == Reader::READ_STATUS::END_OF_FILE || bytes_read == 0) {
+        end_of_file = true;
+        break;
+      }
+    }
+
+    return Reader::READ_STATUS::OK;
+  }
+
+  size_t Available() const { return end - start; }
+  const char *Data() const { return buffer.get() + start; }
+  off_t Offset() const { return offset; }
+
+  void Consume(size_t size)
+  {
+    start += size;
+    offset += size;
+  }
+
+private:
+  Source source;
+  MemoryReservation reserved;
+  std::unique_ptr<char[]> buffer;
+  size_t capacity;
+  size_t start;
+  size_t end;
+  off_t offset;
+  bool end_of_file;
+};
+
+// Returns 1 once a length is decoded, 0 when more bytes are needed and -1 on corruption.
+int DecodeLength(const unsigned char * data, size_t available, FramedReader::FRAMING framing, uint64_t & length, size_t & header) {
+    if (framing == FramedReader::FRAMING::VARINT) {
+        length = 0;
+
+        for (size_t i = 0; i < available && i < MAX_VARINT_SIZE; i++) {
+            length |= static_cast<uint64_t>(data[i] & 0x7F) << (7 * i);
+
+            if ((data[i] & 0x80) == 0) {
+                header = i + 1;
+                return 1;
+            }
+        }
+
+        return available >= MAX_VARINT_SIZE ? -1 : 0;
+    }
+
+    if (available < 4) {
+        return 0;
+    }
+
+    if (framing == FramedReader::FRAMING::U32_LITTLE_ENDIAN) {
+        length = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint64_t>(data[3]) << 24);
+    } else {
+        length = (static_cast<uint64_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    }
+
+    header = 4;
+
+    return 1;
+}
+
+// Read a length (or count) prefix. *found is false when the stream ended cleanly before it.
+Reader::READ_STATUS ReadLength(FrameBuffer & frames, FramedReader::FRAMING framing, uint64_t & length, bool & found) {
+    Reader::READ_STATUS status = frames.Fill(framing == FramedReader::FRAMING::VARINT ? MAX_VARINT_SIZE : 4);
+    size_t header = 0;
+
+    found = false;
+
+    if ((status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR || frames.Available() == 0) {
+        return status;
+    }
+
+    if (DecodeLength(reinterpret_cast<const unsigned char *>(frames.Data()), frames.Available(), framing, length, header) != 1) {
+        return Reader::READ_STATUS::ERROR;
+    }
+
+    frames.Consume(header);
+    found = true;
+
+    return Reader::READ_STATUS::OK;
+}
+
+Reader::READ_STATUS ReadRecord(FrameBuffer & frames, FramedReader::FRAMING framing, size_t max_record_size,
+                               bool & found, std::function<void(const View &)> & callback) {
+    uint64_t length = 0;
+    Reader::READ_STATUS status = ReadLength(frames, framing, length, found);
+
+    if (!found) {
+        return status;
+    }
+
+    if (length > max_record_size) {
+        return Reader::READ_STATUS::ERROR;
+    }
+
+    status = frames.Fill(length);
+
+    // A record cut short by the end of the file.
+    if ((status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR || frames.Available() < length) {
+        return Reader::READ_STATUS::ERROR;
+    }
+
+    callback(View(frames.Data(), length));
+    frames.Consume(length);
+
+    return Reader::READ_STATUS::OK;
+}
+
+// Parse records until the stream ends or, with a marker, until a block would start at or past stop.
+Reader::READ_STATUS ParseFrames(FrameBuffer & frames, FramedReader::FRAMING framing, size_t max_record_size,
+                                const std::string & marker, off_t stop, std::function<void(const View &)> & callback) {
+    const Reader::READ_STATUS done = Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+    bool found = true;
+
+    if (marker.empty()) {
+        while (true) {
+            Reader::READ_STATUS status = ReadRecord(frames, framing, max_record_size, found, callback);
+
+            if ((status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR) {
+                return status;
+            }
+
+            if (!found) {
+                return done;
+            }
+        }
+    }
+
+    while (frames.Offset() < stop) {
+        Reader::READ_STATUS status = frames.Fill(marker.size());
+
+        if ((status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR) {
+            return status;
+        }
+
+        if (frames.Available() == 0) {
+            return done;
+        }
+
+        if (frames.Available() < marker.size() || memcmp(frames.Data(), marker.data(), marker.size()) != 0) {
+            return Reader::READ_STATUS::ERROR;
+        }
+
+        frames.Consume(marker.size());
+
+        uint64_t count = 0;
+        status = ReadLength(frames, framing, count, found);
+
+        if ((status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR || !found) {
+            return Reader::READ_STATUS::ERROR;
+        }
+
+        for (uint64_t i = 0; i < count; i++) {
+            status = ReadRecord(frames, framing, max_record_size, found, callback);
+
+            if ((status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR || !found) {
+                return Reader::READ_STATUS::ERROR;
+            }
+        }
+    }
+
+    return done;
+}
+
+// Find the first marker starting in [start, stop), returning -1 if there is none.
+off_t FindMarker(Reader & reader, const std::string & marker, off_t start, off_t stop, Reader::READ_STATUS & status) {
+    Searcher searcher(marker);
+    std::unique_ptr<char[]> buffer(new (std::nothrow) char[DEFAULT_BUFFER_SIZE + marker.size()]);
+    off_t offset = start;
+
+    status = Reader::READ_STATUS::OK;
+
+    if (!buffer) {
+        status = Reader::READ_STATUS::ERROR;
+        return -1;
+    }
+
+    while (offset < stop) {
+        // Overlap consecutive windows so a marker straddling them is still found.
+        ssize_t bytes_read = 0;
+        status = reader.ReadAt(buffer.get(), DEFAULT_BUFFER_SIZE + marker.size() - 1, offset, &bytes_read);
+
+        if (reader.StatusError(status)) {
+            return -1;
+        }
+
+        size_t position = searcher.Find(buffer.get(), bytes_read);
+
+        if (position != View::npos) {
+            off_t found = offset + static_cast<off_t>(position);
+
+            return found < stop ? found : -1;
+        }
+
+        if (static_cast<size_t>(bytes_read) < DEFAULT_BUFFER_SIZE + marker.size() - 1) {
+            break;
+        }
+
+        offset += DEFAULT_BUFFER_SIZE;
+    }
+
+    return -1;
+}
+
+} // End anonymous namespace
+
+FramedReader::FramedReader(Reader & reader, FRAMING framing) :
+    reader(reader),
+    framing(framing),
+    buffer_size(DEFAULT_BUFFER_SIZE),
+    max_record_size(DEFAULT_MAX_RECORD_SIZE)
+{}
+
+FramedReader & FramedReader::SetBufferSize(size_t size) {
+    buffer_size = size > 0 ? size : 1;
+
+    return *this;
+}
+
+FramedReader & FramedReader::SetMaxRecordSize(size_t size) {
+    max_record_size = size;
+
+    return *this;
+}
+
+FramedReader & FramedReader::SetSyncMarker(const std::string & marker) {
+    this->marker = marker;
+
+    return *this;
+}
+
+Reader::READ_STATUS FramedReader::Read(std::function<void(const View &)> callback) {
+    Reader &source = reader;
+    FrameBuffer frames([&source](char * buffer, size_t size, ssize_t * bytes_read) {
+        return source.Read(buffer, size, bytes_read);
+    }, buffer_size, 0);
+
+    off_t stop = marker.empty() ? 0 : static_cast<off_t>(INT64_MAX);
+
+    return ParseFrames(frames, framing, max_record_size, marker, stop, callback);
+}
+
+Reader::READ_STATUS FramedReader::ParallelRead(const std::string & path, FRAMING framing, const std::string & marker,
+                                               size_t threads, std::function<void(size_t, const View &)> callback,
+                                               size_t max_record_size, MemoryBudget * budget) {
+    // Every worker reads through ReadAt on the one descriptor, so their locks don't collide.
+    Reader reader;
+
+    if (marker.empty() || !File::StatusOk(reader.Open(path))) {
+        return Reader::READ_STATUS::ERROR;
+    }
+
+    const off_t size = reader.Stat().st_size;
+    const size_t max_size = max_record_size > 0 ? max_record_size : DEFAULT_MAX_RECORD_SIZE;
+
+    ThreadPool pool(threads > 0 ? threads : 1);
+
+    // Many more ranges than workers, so a worker stuck on an expensive range doesn't hold
+    // up the rest: the others keep taking ranges.
+    off_t range = size / static_cast<off_t>(pool.Size() * RANGES_PER_WORKER);
+
+    if (range < static_cast<off_t>(MIN_RANGE_SIZE)) {
+        range = MIN_RANGE_SIZE;
+    }
+
+    std::mutex lock;
+    Reader::READ_STATUS result = Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+
+    for (off_t start = 0; start < size; start += range) {
+        const off_t stop = start + range < size ? start + range : size;
+
+        pool.Submit([&, start, stop]() {
+            const size_t worker = pool.WorkerIndex();
+
+            Reader::READ_STATUS status;
+            off_t first_block;
+
+            // Workers wait for room before starting a range, the search window and the
+            // frame buffer are counted in turn.
+            {
+                MemoryReservation searching(budget, DEFAULT_BUFFER_SIZE + marker.size());
+                first_block = FindMarker(reader, marker, start, stop, status);
+            }
+
+            if (!reader.StatusError(status) && first_block >= 0) {
+                off_t position = first_block;
+                FrameBuffer frames([&reader, &position](char * buffer, size_t length, ssize_t * bytes_read) {
+                    Reader::READ_STATUS read_status = reader.ReadAt(buffer, length, position, bytes_read);
+                    position += *bytes_read;
+
+                    return read_status;
+                }, DEFAULT_BUFFER_SIZE, first_block, budget);
+
+                std::function<void(const View &)> on_record = [&callback, worker](const View & record) {
+                    callback(worker, record);
+                };
+
+                status = ParseFrames(frames, framing, max_size, marker, stop, on_record);
+            }
+
+            if (reader.StatusError(status)) {
+                std::lock_guard<std::mutex> guard(lock);
+                result = status;
+            }
+        });
+    }
+
+    pool.Wait();
+
+    return result;
+}
+
+} // End File
@@ -0,0 +1,68 @@
+#ifndef FILE_FRAMED_READER_H
+#define FILE_FRAMED_READER_H
+
+#include <sys/types.h>
+#include <string>
+#include <functional>
+
+#include "file.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+class MemoryBudget;
+
+// Reads a stream of length prefixed records, as written by protobuf or Avro style dumps.
+//
+// Records are handed out as views into an internal buffer. A record cut off by the end of the
+// buffer only costs moving that one partial record to the front, and the buffer only grows
+// when a single record doesn't fit in it.
+//
+// With a sync marker, the stream is a sequence of blocks, each made of the marker, a record
+// count (framed like the lengths) and that many records. The marker lets ParallelRead split
+// the file into ranges that are scanned independently.
+class FramedReader
+{
+public:
+  enum class FRAMING : char
+  {
+    VARINT,
+    U32_LITTLE_ENDIAN,
+    U32_BIG_ENDIAN
+  };
+
+  FramedReader(Reader &reader, FRAMING framing);
+
+  // Initial size of the internal buffer.
+  FramedReader &SetBufferSize(size_t size);
+
+  // Records longer than this are treated as corruption.
+  FramedReader &SetMaxRecordSize(size_t size);
+
+  FramedReader &SetSyncMarker(const std::string &marker);
+
+  // Read every record. Views are only valid during the callback.
+  Reader::READ_STATUS Read(std::function<void(const View &)> callback);
+
+  // Scan a file with sync markers using several threads. The file is cut into ranges run as
+  // tasks on a work stealing pool. A block belongs to the range its marker starts in and bytes
+  // before the first marker are skipped. The callback is called concurrently, along with the
+  // index of the worker. Records longer than max_record_size are treated as corruption, zero
+  // means the same default as SetMaxRecordSize. With a budget shared with other stages, each
+  // worker's buffers count against it while it scans a range.
+  static Reader::READ_STATUS ParallelRead(const std::string &path, FRAMING framing, const std::string &marker,
+                                          size_t threads, std::function<void(size_t, const View &)> callback,
+                                          size_t max_record_size = 0, MemoryBudget *budget = nullptr);
+
+private:
+  Reader &reader;
+  FRAMING framing;
+  size_t buffer_size;
+  size_t max_record_size;
+  std::string marker;
+};
+
+} // End File
+
+#endif // FILE_FRAMED_READER_H
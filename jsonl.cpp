@@ -0,0 +1,360 @@
+#include "jsonl.hpp"
+#include "lines.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace File {
+
+namespace {
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+const char *SkipSpace(const char * cursor, const char * end) {
+    while (cursor < end && IsSpace(*cursor)) {
+        cursor++;
+    }
+
+    return cursor;
+}
+
+// Given the opening quote of a string, find its closing quote.
+const char *StringEnd(const char * cursor, const char * end) {
+    for (cursor++; cursor < end; cursor++) {
+        if (*cursor == '\\') {
+            cursor++;
+        } else if (*cursor == '"') {
+            return cursor;
+        }
+    }
+
+    return nullptr;
+}
+
+// Given the first byte of a value, find the byte right after it.
+const char *SkipValue(const char * cursor, const char * end) {
+    if (cursor >= end) {
+        return nullptr;
+    }
+
+    if (*cursor == '"') {
+        const char *closing = StringEnd(cursor, end);
+
+        return closing == nullptr ? nullptr : closing + 1;
+    }
+
+    if (*cursor == '{' || *cursor == '[') {
+        size_t depth = 0;
+
+        for (; cursor < end; cursor++) {
+            char c = *cursor;
+
+            if (c == '"') {
+                if ((cursor = StringEnd(cursor, end)) == nullptr) {
+                    return nullptr;
+                }
+            } else if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                return cursor + 1;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Numbers, true, false and null.
+    while (cursor < end && *cursor != ',' && *cursor != '}' && *cursor != ']' && !IsSpace(*cursor)) {
+        cursor++;
+    }
+
+    return cursor;
+}
+
+} // End anonymous namespace
+
+JsonLines::JsonLines(VALIDATION validation) :
+    validation(validation)
+{}
+
+bool JsonLines::ValidUtf8(const char * data, size_t size) {
+    const unsigned char *cursor = reinterpret_cast<const unsigned char *>(data);
+    const unsigned char *end = cursor + size;
+
+    while (cursor < end) {
+#ifdef __SSE2__
+        // Plain ASCII is the common case, skip it a block at a time.
+        while (end - cursor >= 16 && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(cursor))) == 0) {
+            cursor += 16;
+        }
+
+        if (cursor >= end) {
+            break;
+        }
+#endif
+
+        unsigned char c = *cursor;
+
+        if (c < 0x80) {
+            cursor++;
+            continue;
+        }
+
+        size_t continuation;
+        uint32_t code_point, minimum;
+
+        if ((c & 0xE0) == 0xC0) {
+            continuation = 1;
+            code_point = c & 0x1F;
+            minimum = 0x80;
+        } else if ((c & 0xF0) == 0xE0) {
+            continuation = 2;
+            code_point = c & 0x0F;
+            minimum = 0x800;
+        } else if ((c & 0xF8) == 0xF0) {
+            continuation = 3;
+            code_point = c & 0x07;
+            minimum = 0x10000;
+        } else {
+            return false;
+        }
+
+        if (static_cast<size_t>(end - cursor) <= continuation) {
+            return false;
+        }
+
+        for (size_t i = 1; i <= continuation; i++) {
+            if ((cursor[i] & 0xC0) != 0x80) {
+                return false;
+            }
+
+            code_point = (code_point << 6) | (cursor[i] & 0x3F);
+        }
+
+        // Reject overlong encodings, surrogates and anything past U+10FFFF.
+        if (code_point < minimum || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+            return false;
+        }
+
+        cursor += continuation + 1;
+    }
+
+    return true;
+}
+
+bool JsonLines::Balanced(const char * data, size_t size) {
+    const char *cursor = data;
+    const char *end = data + size;
+
+    // Short enough to stay in the small string buffer for ordinary records.
+    std::string open;
+    bool in_string = false;
+
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i open_brace = _mm_set1_epi8('{');
+    const __m128i close_brace = _mm_set1_epi8('}');
+    const __m128i open_bracket = _mm_set1_epi8('[');
+    const __m128i close_bracket = _mm_set1_epi8(']');
+#endif
+
+    while (cursor < end) {
+#ifdef __SSE2__
+        // Skip blocks without a single byte that could change the structure.
+        while (end - cursor >= 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cursor));
+            __m128i found = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash));
+
+            found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(block, open_brace), _mm_cmpeq_epi8(block, close_brace)));
+            found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(block, open_bracket), _mm_cmpeq_epi8(block, close_bracket)));
+
+            unsigned mask = _mm_movemask_epi8(found);
+
+            if (mask != 0) {
+                cursor += __builtin_ctz(mask);
+                break;
+            }
+
+            cursor += 16;
+        }
+
+        if (cursor >= end) {
+            break;
+        }
+#endif
+
+        char c = *cursor++;
+
+        if (in_string) {
+            if (c == '\\') {
+                cursor++;
+            } else if (c == '"') {
+                in_string = false;
+            }
+
+            continue;
+        }
+
+        switch (c) {
+            case '"':
+                in_string = true;
+                break;
+            case '{':
+            case '[':
+                open += c;
+                break;
+            case '}':
+            case ']':
+                if (open.empty() || open.back() != (c == '}' ? '{' : '[')) {
+                    return false;
+                }
+
+                open.pop_back();
+                break;
+        }
+    }
+
+    return !in_string && open.empty();
+}
+
+size_t JsonLines::Extract(const View & record, const std::vector<std::string> & keys, std::vector<View> & values) {
+    values.assign(keys.size(), View());
+
+    const char *end = record.end();
+    const char *cursor = SkipSpace(record.begin(), end);
+    size_t found = 0;
+
+    if (cursor >= end || *cursor != '{') {
+        return 0;
+    }
+
+    cursor++;
+
+    while (found < keys.size()) {
+        cursor = SkipSpace(cursor, end);
+
+        if (cursor >= end || *cursor != '"') {
+            break;
+        }
+
+        const char *key_end = StringEnd(cursor, end);
+
+        if (key_end == nullptr) {
+            break;
+        }
+
+        View key(cursor + 1, key_end - cursor - 1);
+        cursor = SkipSpace(key_end + 1, end);
+
+        if (cursor >= end || *cursor != ':') {
+            break;
+        }
+
+        cursor = SkipSpace(cursor + 1, end);
+
+        const char *value_end = SkipValue(cursor, end);
+
+        if (value_end == nullptr || value_end == cursor) {
+            break;
+        }
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (values[i].empty() && key == View(keys[i])) {
+                values[i] = View(cursor, value_end - cursor);
+                found++;
+            }
+        }
+
+        cursor = SkipSpace(value_end, end);
+
+        if (cursor >= end || *cursor != ',') {
+            break;
+        }
+
+        cursor++;
+    }
+
+    return found;
+}
+
+bool JsonLines::Extract(const View & record, const std::string & key, View & value) {
+    std::vector<View> values;
+
+    if (Extract(record, std::vector<std::string>(1, key), values) == 0) {
+        return false;
+    }
+
+    value = values[0];
+
+    return true;
+}
+
+bool JsonLines::Valid(const View & record, bool block_is_utf8) const {
+    if ((validation & VALIDATION::UTF8) == VALIDATION::UTF8 && !block_is_utf8 && !ValidUtf8(record.data(), record.size())) {
+        return false;
+    }
+
+    if ((validation & VALIDATION::STRUCTURE) == VALIDATION::STRUCTURE && !Balanced(record.data(), record.size())) {
+        return false;
+    }
+
+    return true;
+}
+
+Reader::READ_STATUS JsonLines::Parse(Reader & reader, std::function<void(off_t, const View &)> callback,
+                                     std::function<void(off_t, const View &)> invalid_callback) {
+    LineSplitter splitter;
+    const bool check_utf8 = (validation & VALIDATION::UTF8) == VALIDATION::UTF8;
+
+    auto parse_block = [&](off_t offset, const View & block) {
+        // Validate the whole block in one go, records only need checking one by one if it fails.
+        bool block_is_utf8 = check_utf8 && ValidUtf8(block.data(), block.size());
+
+        const char *begin = block.begin();
+        const char *end = block.end();
+        const char *line_start = begin;
+
+        while (line_start < end) {
+            const char *line_end = static_cast<const char *>(memchr(line_start, '\n', end - line_start));
+            line_end = line_end == nullptr ? end : line_end;
+
+            const char *record_end = line_end;
+
+            while (record_end > line_start && IsSpace(*(record_end - 1))) {
+                record_end--;
+            }
+
+            if (SkipSpace(line_start, record_end) < record_end) {
+                View record(line_start, record_end - line_start);
+                off_t record_offset = offset + (line_start - begin);
+
+                if (Valid(record, block_is_utf8)) {
+                    callback(record_offset, record);
+                } else if (invalid_callback) {
+                    invalid_callback(record_offset, record);
+                }
+            }
+
+            line_start = line_end + 1;
+        }
+    };
+
+    Reader::READ_STATUS status = reader.Read([&](std::string & chunk) {
+        splitter.FeedBlocks(chunk.data(), chunk.size(), parse_block);
+    });
+
+    if (!reader.StatusError(status)) {
+        splitter.FinishBlocks(parse_block);
+    }
+
+    return status;
+}
+
+} // End File
@@ -0,0 +1,57 @@
+#ifndef FILE_JSONL_H
+#define FILE_JSONL_H
+
+#include <sys/types.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "file.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+// Splits JSON Lines into records without parsing them. Records can be checked in bulk for
+// valid UTF-8 and balanced brackets, and top-level values can be pulled out lazily, so
+// filtering on a field never needs a full parse.
+class JsonLines
+{
+public:
+  enum class VALIDATION : char
+  {
+    NONE = 0,
+    UTF8 = 1,
+    STRUCTURE = 1 << 1
+  };
+
+  explicit JsonLines(VALIDATION validation = VALIDATION::NONE);
+
+  // Hand out every non-blank record with its file offset. Records failing validation go to
+  // invalid_callback instead, when one is given.
+  Reader::READ_STATUS Parse(Reader &reader, std::function<void(off_t, const View &)> callback,
+                            std::function<void(off_t, const View &)> invalid_callback = nullptr);
+
+  // Whether the bytes are well formed UTF-8, checking 16 bytes at a time for plain ASCII.
+  static bool ValidUtf8(const char *data, size_t size);
+
+  // Whether strings are terminated and brackets/braces balanced outside of strings.
+  static bool Balanced(const char *data, size_t size);
+
+  // Find the raw JSON text of a top-level value in an object record. Keys are compared
+  // byte for byte with their raw (still escaped) form.
+  static bool Extract(const View &record, const std::string &key, View &value);
+
+  // Find several top-level values in a single pass, returning how many were found.
+  // values[i] is left empty for keys that aren't present.
+  static size_t Extract(const View &record, const std::vector<std::string> &keys, std::vector<View> &values);
+
+private:
+  VALIDATION validation;
+
+  bool Valid(const View &record, bool block_is_utf8) const;
+};
+
+} // End File
+
+#endif // FILE_JSONL_H
@@ -0,0 +1,82 @@
+#include "lines.hpp"
+
+#include <string.h>
+
+namespace File {
+
+LineSplitter::LineSplitter() :
+    offset(0)
+{}
+
+void LineSplitter::FeedBlocks(const char * data, size_t size, std::function<void(off_t, const View &)> callback) {
+    const char *end = data + size;
+    const char *newline = static_cast<const char *>(memchr(data, '\n', size));
+
+    if (newline == nullptr) {
+        carry.append(data, size);
+        return;
+    }
+
+    // The line left over from the previous chunk is completed by the head of this one.
+    if (!carry.empty()) {
+        carry.append(data, newline + 1 - data);
+        callback(offset, View(carry));
+
+        offset += carry.size();
+        carry.clear();
+        data = newline + 1;
+    }
+
+    const char *last_newline = static_cast<const char *>(memrchr(data, '\n', end - data));
+
+    if (last_newline != nullptr) {
+        size_t block_size = last_newline + 1 - data;
+
+        callback(offset, View(data, block_size));
+
+        offset += block_size;
+        data = last_newline + 1;
+    }
+
+    carry.assign(data, end - data);
+}
+
+void LineSplitter::Feed(const char * data, size_t size, std::function<void(const View &)> callback) {
+    FeedBlocks(data, size, [&callback](off_t, const View & block) {
+        const char *begin = block.begin();
+        const char *end = block.end();
+        const char *newline;
+
+        while ((newline = static_cast<const char *>(memchr(begin, '\n', end - begin))) != nullptr) {
+            callback(View(begin, newline - begin));
+            begin = newline + 1;
+        }
+    });
+}
+
+void LineSplitter::Feed(const std::string & chunk, std::function<void(const View &)> callback) {
+    Feed(chunk.data(), chunk.size(), callback);
+}
+
+void LineSplitter::Finish(std::function<void(const View &)> callback) {
+    if (!carry.empty()) {
+        callback(View(carry));
+    }
+
+    Reset();
+}
+
+void LineSplitter::FinishBlocks(std::function<void(off_t, const View &)> callback) {
+    if (!carry.empty()) {
+        callback(offset, View(carry));
+    }
+
+    Reset();
+}
+
+void LineSplitter::Reset() {
+    carry.clear();
+    offset = 0;
+}
+
+} // End File
@@ -0,0 +1,43 @@
+#ifndef FILE_LINES_H
+#define FILE_LINES_H
+
+#include <sys/types.h>
+#include <string>
+#include <functional>
+
+#include "view.hpp"
+
+namespace File
+{
+
+// Splits a stream of chunks into lines, carrying partial lines across chunk boundaries.
+// Lines are handed out as views without their terminating newline.
+class LineSplitter
+{
+public:
+  LineSplitter();
+
+  // Feed the next chunk, receiving blocks made only of complete lines together with the
+  // file offset of the block. Every line in a block ends with '\n', only the block handed
+  // out by FinishBlocks may end without one.
+  void FeedBlocks(const char *data, size_t size, std::function<void(off_t, const View &)> callback);
+
+  // Feed the next chunk, receiving every line it completes.
+  void Feed(const char *data, size_t size, std::function<void(const View &)> callback);
+  void Feed(const std::string &chunk, std::function<void(const View &)> callback);
+
+  // Hand out the final line if the stream didn't end with a newline.
+  void Finish(std::function<void(const View &)> callback);
+  void FinishBlocks(std::function<void(off_t, const View &)> callback);
+
+  // Forget any partial line and start over at offset 0.
+  void Reset();
+
+private:
+  std::string carry;
+  off_t offset;
+};
+
+} // End File
+
+#endif // FILE_LINES_H
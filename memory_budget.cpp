@@ -0,0 +1,152 @@
+#include "memory_budget.hpp"
+
+#include <chrono>
+
+namespace File {
+
+MemoryBudget::MemoryBudget(size_t limit) :
+    limit(limit),
+    in_use(0),
+    peak(0),
+    stalls(0),
+    stalled_nanoseconds(0)
+{}
+
+bool MemoryBudget::Fits(size_t bytes) const {
+    return in_use == 0 || in_use + bytes <= limit;
+}
+
+void MemoryBudget::Take(size_t bytes) {
+    in_use += bytes;
+
+    if (in_use > peak) {
+        peak = in_use;
+    }
+}
+
+void MemoryBudget::Reserve(size_t bytes) {
+    std::unique_lock<std::mutex> guard(lock);
+
+    if (!Fits(bytes)) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        room.wait(guard, [this, bytes]() {
+            return Fits(bytes);
+        });
+
+        stalls++;
+        stalled_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    Take(bytes);
+}
+
+bool MemoryBudget::TryReserve(size_t bytes) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (!Fits(bytes)) {
+        return false;
+    }
+
+    Take(bytes);
+
+    return true;
+}
+
+void MemoryBudget::Release(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        in_use -= bytes < in_use ? bytes : in_use;
+    }
+
+    room.notify_all();
+}
+
+void MemoryBudget::SetLimit(size_t new_limit) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        limit = new_limit;
+    }
+
+    room.notify_all();
+}
+
+size_t MemoryBudget::Limit() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return limit;
+}
+
+size_t MemoryBudget::InUse() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return in_use;
+}
+
+size_t MemoryBudget::Peak() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return peak;
+}
+
+uint64_t MemoryBudget::Stalls() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return stalls;
+}
+
+uint64_t MemoryBudget::StalledNanoseconds() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return stalled_nanoseconds;
+}
+
+MemoryReservation::MemoryReservation(MemoryBudget * budget, size_t bytes) :
+    budget(budget),
+    bytes(0)
+{
+    Resize(bytes);
+}
+
+MemoryReservation::MemoryReservation(MemoryReservation && other) noexcept :
+    budget(other.budget),
+    bytes(other.bytes)
+{
+    other.bytes = 0;
+}
+
+MemoryReservation::~MemoryReservation() {
+    Resize(0);
+}
+
+void MemoryReservation::Resize(size_t new_bytes) {
+    if (budget == nullptr || new_bytes <= bytes) {
+        if (budget != nullptr && new_bytes < bytes) {
+            budget->Release(bytes - new_bytes);
+        }
+
+        bytes = new_bytes;
+        return;
+    }
+
+    if (bytes > 0) {
+        budget->Release(bytes);
+        bytes = 0;
+    }
+
+    budget->Reserve(new_bytes);
+    bytes = new_bytes;
+}
+
+bool MemoryReservation::TryResize(size_t new_bytes) {
+    if (budget == nullptr || new_bytes <= bytes) {
+        Resize(new_bytes);
+        return true;
+    }
+
+    if (!budget->TryReserve(new_bytes - bytes)) {
+        return false;
+    }
+
+    bytes = new_bytes;
+
+    return true;
+}
+
+} // End File
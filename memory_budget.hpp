@@ -0,0 +1,85 @@
+#ifndef FILE_MEMORY_BUDGET_H
+#define FILE_MEMORY_BUDGET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+
+namespace File
+{
+
+// A limit on the bytes in flight between producers and consumers, shared by every stage
+// that reads ahead or in parallel: BatchReader workers, the Parallel and OrderedMap pipeline
+// stages, ParallelScanner, FramedReader::ParallelRead, AsyncReader and ExternalSorter.
+// Producers reserve bytes before reading or handing off a batch and block while the budget
+// is used up, consumers release them once done, so a fast reader can't outgrow memory.
+class MemoryBudget
+{
+public:
+  explicit MemoryBudget(size_t limit);
+
+  // Block until bytes fit in the budget, then take them. A reservation larger than the
+  // whole budget is let through once nothing else is reserved, rather than never.
+  void Reserve(size_t bytes);
+
+  // Take bytes if they fit right away.
+  bool TryReserve(size_t bytes);
+
+  void Release(size_t bytes);
+
+  // Raising the limit wakes blocked producers.
+  void SetLimit(size_t limit);
+
+  size_t Limit() const;
+  size_t InUse() const;
+  size_t Peak() const;
+
+  // How often, and for how long in total, producers were held back.
+  uint64_t Stalls() const;
+  uint64_t StalledNanoseconds() const;
+
+private:
+  mutable std::mutex lock;
+  std::condition_variable room;
+
+  size_t limit;
+  size_t in_use;
+  size_t peak;
+  uint64_t stalls;
+  uint64_t stalled_nanoseconds;
+
+  // Whether bytes fit. The lock must be held.
+  bool Fits(size_t bytes) const;
+  void Take(size_t bytes);
+};
+
+// Bytes held from a budget, if there is one, and given back on destruction. Growing gives
+// back what's held before waiting for the larger amount, so a holder never waits while
+// holding anything, and holders growing at the same time can't deadlock.
+class MemoryReservation
+{
+public:
+  explicit MemoryReservation(MemoryBudget *budget, size_t bytes = 0);
+  MemoryReservation(MemoryReservation &&other) noexcept;
+  ~MemoryReservation();
+
+  MemoryReservation(const MemoryReservation &) = delete;
+  MemoryReservation &operator=(const MemoryReservation &) = delete;
+
+  // Hold bytes, blocking while they don't fit.
+  void Resize(size_t bytes);
+
+  // Hold bytes if they fit right away, otherwise keep what's held.
+  bool TryResize(size_t bytes);
+
+  size_t Bytes() const { return bytes; }
+
+private:
+  MemoryBudget *budget;
+  size_t bytes;
+};
+
+} // End File
+
+#endif // FILE_MEMORY_BUDGET_H
@@ -0,0 +1,239 @@
+#include "multi_search.hpp"
+
+#include <string.h>
+#include <deque>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace File {
+
+namespace {
+
+// The prefilter compares every block against each start byte, so it only pays off for a few.
+const size_t MAX_PREFILTER_BYTES = 8;
+
+const uint32_t NO_STATE = static_cast<uint32_t>(-1);
+
+// Skip ahead to the next byte that can start a match.
+const unsigned char *NextCandidate(const unsigned char * cursor, const unsigned char * end, const std::string & start_bytes) {
+    if (start_bytes.size() == 1) {
+        const void *match = memchr(cursor, start_bytes[0], end - cursor);
+
+        return match == nullptr ? end : static_cast<const unsigned char *>(match);
+    }
+
+#ifdef __SSE2__
+    __m128i needles[MAX_PREFILTER_BYTES];
+
+    for (size_t i = 0; i < start_bytes.size(); i++) {
+        needles[i] = _mm_set1_epi8(start_bytes[i]);
+    }
+
+    for (; cursor + 16 <= end; cursor += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cursor));
+        __m128i found = _mm_cmpeq_epi8(block, needles[0]);
+
+        for (size_t i = 1; i < start_bytes.size(); i++) {
+            found = _mm_or_si128(found, _mm_cmpeq_epi8(block, needles[i]));
+        }
+
+        unsigned mask = _mm_movemask_epi8(found);
+
+        if (mask != 0) {
+            return cursor + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; cursor < end; cursor++) {
+        if (start_bytes.find(static_cast<char>(*cursor)) != std::string::npos) {
+            break;
+        }
+    }
+
+    return cursor;
+}
+
+} // End anonymous namespace
+
+PatternSet::PatternSet(const std::vector<std::string> & patterns) :
+    patterns(patterns),
+    class_count(1)
+{
+    // Class 0 is shared by every byte that doesn't appear in any pattern.
+    memset(byte_classes, 0, sizeof(byte_classes));
+
+    for (const std::string & pattern : patterns) {
+        for (unsigned char byte : pattern) {
+            if (byte_classes[byte] == 0) {
+                byte_classes[byte] = class_count++;
+            }
+        }
+    }
+
+    // Build the trie, with NO_STATE marking missing edges.
+    std::vector<uint32_t> next(class_count, NO_STATE);
+    std::vector<std::vector<uint32_t>> own_outputs(1);
+
+    for (size_t id = 0; id < patterns.size(); id++) {
+        if (patterns[id].empty()) {
+            continue;
+        }
+
+        uint32_t state = 0;
+
+        for (unsigned char byte : patterns[id]) {
+            uint32_t &edge = next[state * class_count + byte_classes[byte]];
+
+            if (edge == NO_STATE) {
+                edge = own_outputs.size();
+                own_outputs.emplace_back();
+                next.resize(next.size() + class_count, NO_STATE);
+            }
+
+            state = next[state * class_count + byte_classes[byte]];
+        }
+
+        own_outputs[state].push_back(id);
+    }
+
+    const size_t state_count = own_outputs.size();
+    std::vector<uint32_t> failure(state_count, 0);
+    dictionary_links.assign(state_count, 0);
+
+    // Breadth first, turning the trie into a full DFA by borrowing missing edges from the
+    // failure state, which is always shallower and therefore already complete.
+    std::deque<uint32_t> queue;
+
+    for (uint32_t c = 0; c < class_count; c++) {
+        if (next[c] == NO_STATE) {
+            next[c] = 0;
+        } else {
+            queue.push_back(next[c]);
+        }
+    }
+
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop_front();
+
+        for (uint32_t c = 0; c < class_count; c++) {
+            uint32_t &edge = next[state * class_count + c];
+            uint32_t fallback = next[failure[state] * class_count + c];
+
+            if (edge == NO_STATE) {
+                edge = fallback;
+                continue;
+            }
+
+            failure[edge] = fallback;
+            dictionary_links[edge] = own_outputs[fallback].empty() ? dictionary_links[fallback] : fallback;
+            queue.push_back(edge);
+        }
+    }
+
+    transitions.resize(next.size());
+
+    for (size_t i = 0; i < next.size(); i++) {
+        uint32_t target = next[i];
+        bool matches = !own_outputs[target].empty() || dictionary_links[target] != 0;
+
+        transitions[i] = target * class_count | (matches ? MATCH_FLAG : 0);
+    }
+
+    output_start.reserve(state_count + 1);
+
+    for (size_t state = 0; state < state_count; state++) {
+        output_start.push_back(outputs.size());
+        outputs.insert(outputs.end(), own_outputs[state].begin(), own_outputs[state].end());
+    }
+
+    output_start.push_back(outputs.size());
+
+    for (const std::string & pattern : patterns) {
+        if (!pattern.empty() && start_bytes.find(pattern[0]) == std::string::npos) {
+            start_bytes += pattern[0];
+        }
+    }
+
+    if (start_bytes.size() > MAX_PREFILTER_BYTES) {
+        start_bytes.clear();
+    }
+}
+
+size_t PatternSet::Size() const {
+    return patterns.size();
+}
+
+const std::string & PatternSet::Pattern(size_t id) const {
+    return patterns[id];
+}
+
+MultiSearcher::MultiSearcher(const PatternSet & set) :
+    set(set),
+    state(0),
+    offset(0)
+{}
+
+void MultiSearcher::Feed(const char * data, size_t size, std::function<void(size_t, off_t)> callback) {
+    const uint32_t *table = set.transitions.data();
+    const uint16_t *classes = set.byte_classes;
+    const bool prefilter = !set.start_bytes.empty();
+
+    const unsigned char *begin = reinterpret_cast<const unsigned char *>(data);
+    const unsigned char *end = begin + size;
+    const unsigned char *cursor = begin;
+    uint32_t row = state;
+
+    while (cursor < end) {
+        // Outside of a partial match only a pattern's first byte can move the automaton.
+        if (row == 0 && prefilter) {
+            cursor = NextCandidate(cursor, end, set.start_bytes);
+
+            if (cursor == end) {
+                break;
+            }
+        }
+
+        uint32_t entry = table[row + classes[*cursor]];
+        row = entry & ~PatternSet::MATCH_FLAG;
+
+        if (entry & PatternSet::MATCH_FLAG) {
+            Report(row, offset + (cursor - begin), callback);
+        }
+
+        cursor++;
+    }
+
+    state = row;
+    offset += size;
+}
+
+void MultiSearcher::Report(uint32_t row, off_t end, std::function<void(size_t, off_t)> & callback) const {
+    uint32_t current = row / set.class_count;
+
+    while (current != 0) {
+        for (uint32_t i = set.output_start[current]; i < set.output_start[current + 1]; i++) {
+            uint32_t id = set.outputs[i];
+
+            callback(id, end + 1 - set.patterns[id].size());
+        }
+
+        current = set.dictionary_links[current];
+    }
+}
+
+Reader::READ_STATUS MultiSearcher::Search(Reader & reader, std::function<void(size_t, off_t)> callback) {
+    return reader.Read([&](std::string & chunk) {
+        Feed(chunk.data(), chunk.size(), callback);
+    });
+}
+
+void MultiSearcher::Reset() {
+    state = 0;
+    offset = 0;
+}
+
+} // End File
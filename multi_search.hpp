@@ -0,0 +1,82 @@
+#ifndef FILE_MULTI_SEARCH_H
+#define FILE_MULTI_SEARCH_H
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "file.hpp"
+
+namespace File
+{
+
+// A set of patterns compiled once into an Aho-Corasick automaton, so that any number of
+// patterns can be matched in a single pass over the data.
+//
+// The automaton is stored as a dense transition table over byte classes (every byte that
+// doesn't appear in a pattern shares one class), with each row premultiplied so a lookup
+// is a single add. Small sets also get a vectorized prefilter over the patterns' first bytes.
+class PatternSet
+{
+public:
+  // Empty patterns are ignored, they never match.
+  explicit PatternSet(const std::vector<std::string> &patterns);
+
+  size_t Size() const;
+  const std::string &Pattern(size_t id) const;
+
+private:
+  friend class MultiSearcher;
+
+  // Set on a transition whose target state reports at least one match.
+  static const uint32_t MATCH_FLAG = 0x80000000u;
+
+  std::vector<std::string> patterns;
+
+  // Up to 257 classes, counting class 0, so a byte wide table would wrap.
+  uint16_t byte_classes[256];
+  uint32_t class_count;
+
+  // transitions[row + byte_classes[byte]], rows are premultiplied by class_count.
+  std::vector<uint32_t> transitions;
+
+  // Pattern ids ending at each state: outputs[output_start[state] .. output_start[state + 1]).
+  std::vector<uint32_t> output_start;
+  std::vector<uint32_t> outputs;
+
+  // The next state along the failure chain that has outputs of its own, 0 if none.
+  std::vector<uint32_t> dictionary_links;
+
+  // Distinct first bytes of all the patterns, when there are few enough to prefilter on.
+  std::string start_bytes;
+};
+
+// Runs a PatternSet over a stream, carrying the automaton state across chunk boundaries.
+class MultiSearcher
+{
+public:
+  explicit MultiSearcher(const PatternSet &set);
+
+  // Feed the next chunk. The callback receives the pattern id and the stream offset at
+  // which the match starts.
+  void Feed(const char *data, size_t size, std::function<void(size_t, off_t)> callback);
+
+  // Feed every chunk of the reader's stream.
+  Reader::READ_STATUS Search(Reader &reader, std::function<void(size_t, off_t)> callback);
+
+  // Start over at offset 0.
+  void Reset();
+
+private:
+  const PatternSet &set;
+  uint32_t state;
+  off_t offset;
+
+  void Report(uint32_t row, off_t end, std::function<void(size_t, off_t)> &callback) const;
+};
+
+} // End File
+
+#endif // FILE_MULTI_SEARCH_H
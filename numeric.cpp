@@ -0,0 +1,374 @@
+#include "numeric.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace File {
+
+namespace {
+
+const uint64_t MAX_EXACT_SIGNIFICAND = static_cast<uint64_t>(1) << 53;
+const int MAX_EXACT_EXPONENT = 22;
+const int MAX_SIGNIFICANT_DIGITS = 19;
+
+const double EXACT_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool IsDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+void Trim(const char *& begin, const char *& end) {
+    while (begin < end && IsSpace(*begin)) {
+        begin++;
+    }
+
+    while (end > begin && IsSpace(*(end - 1))) {
+        end--;
+    }
+}
+
+// Whether the next eight bytes are all digits, checked as one 64 bit word.
+bool EightDigits(const char * cursor, uint64_t & word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&word, cursor, sizeof(word));
+
+    return (((word & 0xF0F0F0F0F0F0F0F0ull) | (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+            == 0x3333333333333333ull);
+#else
+    (void) cursor;
+    (void) word;
+
+    return false;
+#endif
+}
+
+// Turn eight ASCII digits into their value with three multiplications.
+uint32_t ParseEightDigits(uint64_t word) {
+    const uint64_t mask = 0x000000FF000000FFull;
+    const uint64_t multiplier_high = 100 + (1000000ull << 32);
+    const uint64_t multiplier_low = 1 + (10000ull << 32);
+
+    word -= 0x3030303030303030ull;
+    word = (word * 10) + (word >> 8);
+    word = (((word & mask) * multiplier_high) + (((word >> 16) & mask) * multiplier_low)) >> 32;
+
+    return static_cast<uint32_t>(word);
+}
+
+// Accumulate digits into value, returning false on overflow.
+bool ParseDigits(const char *& cursor, const char * end, uint64_t & value) {
+    uint64_t word;
+
+    while (end - cursor >= 8 && EightDigits(cursor, word)) {
+        if (__builtin_mul_overflow(value, 100000000ull, &value) || __builtin_add_overflow(value, ParseEightDigits(word), &value)) {
+            return false;
+        }
+
+        cursor += 8;
+    }
+
+    while (cursor < end && IsDigit(*cursor)) {
+        if (__builtin_mul_overflow(value, 10ull, &value) || __builtin_add_overflow(value, static_cast<uint64_t>(*cursor - '0'), &value)) {
+            return false;
+        }
+
+        cursor++;
+    }
+
+    return true;
+}
+
+bool ParseDoubleSlow(const char * begin, const char * end, double & value) {
+    char small[64];
+    std::string large;
+    const char *text;
+    size_t length = end - begin;
+
+    if (length < sizeof(small)) {
+        memcpy(small, begin, length);
+        small[length] = '\0';
+        text = small;
+    } else {
+        large.assign(begin, length);
+        text = large.c_str();
+    }
+
+    char *parsed_end = nullptr;
+    value = strtod(text, &parsed_end);
+
+    return parsed_end == text + length;
+}
+
+// Find the next delimiter or newline.
+const char *FindSeparator(const char * cursor, const char * end, char delimiter) {
+#ifdef __SSE2__
+    const __m128i delimiters = _mm_set1_epi8(delimiter);
+    const __m128i newlines = _mm_set1_epi8('\n');
+
+    for (; end - cursor >= 16; cursor += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cursor));
+        unsigned mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, delimiters), _mm_cmpeq_epi8(block, newlines)));
+
+        if (mask != 0) {
+            return cursor + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; cursor < end; cursor++) {
+        if (*cursor == delimiter || *cursor == '\n') {
+            break;
+        }
+    }
+
+    return cursor;
+}
+
+bool Parse(const View & field, int64_t & value) {
+    return ParseInteger(field, value);
+}
+
+bool Parse(const View & field, double & value) {
+    return ParseDouble(field, value);
+}
+
+} // End anonymous namespace
+
+bool ParseInteger(const View & token, int64_t & value) {
+    const char *cursor = token.begin();
+    const char *end = token.end();
+
+    Trim(cursor, end);
+
+    bool negative = cursor < end && *cursor == '-';
+
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+        cursor++;
+    }
+
+    const char *digits = cursor;
+    uint64_t magnitude = 0;
+
+    if (!ParseDigits(cursor, end, magnitude) || cursor == digits || cursor != end) {
+        return false;
+    }
+
+    const uint64_t limit = static_cast<uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+
+    if (magnitude > limit) {
+        return false;
+    }
+
+    value = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+
+    return true;
+}
+
+bool ParseDouble(const View & token, double & value) {
+    const char *begin = token.begin();
+    const char *end = token.end();
+
+    Trim(begin, end);
+
+    const char *cursor = begin;
+    bool negative = cursor < end && *cursor == '-';
+
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+        cursor++;
+    }
+
+    // Leading zeros don't count towards the significant digits.
+    const char *integer_start = cursor;
+
+    while (cursor < end && *cursor == '0') {
+        cursor++;
+    }
+
+    uint64_t significand = 0;
+    const char *significant_start = cursor;
+    bool fits = ParseDigits(cursor, end, significand);
+    int digits = cursor - significant_start;
+    bool any_digits = cursor > integer_start;
+    int exponent = 0;
+
+    if (fits && cursor < end && *cursor == '.') {
+        cursor++;
+
+        const char *fraction_start = cursor;
+
+        // Leading zeros of a fraction only move the exponent, when nothing came before.
+        if (significand == 0) {
+            while (cursor < end && *cursor == '0') {
+                cursor++;
+            }
+        }
+
+        const char *fraction_digits = cursor;
+
+        fits = ParseDigits(cursor, end, significand);
+        digits += cursor - fraction_digits;
+        exponent -= cursor - fraction_start;
+        any_digits = any_digits || cursor > fraction_start;
+    }
+
+    if (fits && any_digits && cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+        cursor++;
+
+        bool negative_exponent = cursor < end && *cursor == '-';
+
+        if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+            cursor++;
+        }
+
+        const char *exponent_start = cursor;
+        int explicit_exponent = 0;
+
+        while (cursor < end && IsDigit(*cursor) && explicit_exponent < 100000) {
+            explicit_exponent = explicit_exponent * 10 + (*cursor++ - '0');
+        }
+
+        if (cursor == exponent_start) {
+            return false;
+        }
+
+        exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+    }
+
+    // Anything unusual (inf, nan, hex floats, huge significands) is left to strtod.
+    if (!fits || !any_digits || cursor != end || digits > MAX_SIGNIFICANT_DIGITS) {
+        return ParseDoubleSlow(begin, end, value);
+    }
+
+    if (significand <= MAX_EXACT_SIGNIFICAND && exponent >= -MAX_EXACT_EXPONENT && exponent <= MAX_EXACT_EXPONENT) {
+        // Both operands are exact, so the single rounding of the operation is correct.
+        double result = static_cast<double>(significand);
+
+        result = exponent < 0 ? result / EXACT_POWERS_OF_TEN[-exponent] : result * EXACT_POWERS_OF_TEN[exponent];
+        value = negative ? -result : result;
+
+        return true;
+    }
+
+    return ParseDoubleSlow(begin, end, value);
+}
+
+NumberReader::NumberReader(Reader & reader, char delimiter) :
+    reader(reader),
+    delimiter(delimiter),
+    column(0),
+    all_columns(true),
+    position(0),
+    end_of_file(false),
+    current_column(0),
+    invalid(0)
+{}
+
+NumberReader & NumberReader::SetColumn(size_t column) {
+    this->column = column;
+    all_columns = false;
+
+    return *this;
+}
+
+size_t NumberReader::Invalid() const {
+    return invalid;
+}
+
+Reader::READ_STATUS NumberReader::Read(int64_t * values, size_t capacity, size_t * count) {
+    return ReadNumbers(values, capacity, count);
+}
+
+Reader::READ_STATUS NumberReader::Read(double * values, size_t capacity, size_t * count) {
+    return ReadNumbers(values, capacity, count);
+}
+
+template <typename T>
+void NumberReader::Emit(const View & field, char separator, T * values, size_t * count) {
+    if (all_columns || current_column == column) {
+        T value;
+        const char *begin = field.begin();
+        const char *end = field.end();
+
+        Trim(begin, end);
+
+        if (begin < end) {
+            if (Parse(View(begin, end - begin), value)) {
+                values[(*count)++] = value;
+            } else {
+                invalid++;
+            }
+        }
+    }
+
+    current_column = separator == '\n' ? 0 : current_column + 1;
+}
+
+template <typename T>
+Reader::READ_STATUS NumberReader::ReadNumbers(T * values, size_t capacity, size_t * count) {
+    *count = 0;
+
+    while (*count < capacity) {
+        if (position >= chunk.size()) {
+            if (end_of_file) {
+                // The stream didn't end with a separator.
+                if (!carry.empty()) {
+                    Emit(View(carry), '\n', values, count);
+                    carry.clear();
+                }
+
+                return Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+            }
+
+            Reader::READ_STATUS status = reader.Read(chunk);
+
+            if (reader.StatusError(status)) {
+                return status;
+            }
+
+            end_of_file = reader.StatusEndOfFile(status);
+            position = 0;
+
+            continue;
+        }
+
+        const char *start = chunk.data() + position;
+        const char *end = chunk.data() + chunk.size();
+        const char *separator = FindSeparator(start, end, delimiter);
+
+        if (separator == end) {
+            carry.append(start, end - start);
+            position = chunk.size();
+
+            continue;
+        }
+
+        if (carry.empty()) {
+            Emit(View(start, separator - start), *separator, values, count);
+        } else {
+            carry.append(start, separator - start);
+            Emit(View(carry), *separator, values, count);
+            carry.clear();
+        }
+
+        position = separator + 1 - chunk.data();
+    }
+
+    if (end_of_file && position >= chunk.size() && carry.empty()) {
+        return Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+    }
+
+    return Reader::READ_STATUS::OK;
+}
+
+} // End File
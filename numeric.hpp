@@ -0,0 +1,61 @@
+#ifndef FILE_NUMERIC_H
+#define FILE_NUMERIC_H
+
+#include <stdint.h>
+#include <string>
+
+#include "file.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+// Parse a whole token as a number, surrounding spaces aside. Digits are consumed eight at a
+// time with SWAR arithmetic. Doubles take the exact Clinger fast path whenever the
+// significand fits in 53 bits and the decimal exponent in [-22, 22], falling back to strtod.
+bool ParseInteger(const View &token, int64_t &value);
+bool ParseDouble(const View &token, double &value);
+
+// Reads delimited numbers (one per line, or separated by a delimiter) straight out of the
+// reader's chunks into caller provided arrays, without building a string per field.
+class NumberReader
+{
+public:
+  explicit NumberReader(Reader &reader, char delimiter = ',');
+
+  // Only parse the given zero based column of each line, instead of every field.
+  NumberReader &SetColumn(size_t column);
+
+  // Write up to capacity numbers into values, storing how many were written in *count.
+  // Returns END_OF_FILE once the stream is exhausted, *count may still be non zero then.
+  Reader::READ_STATUS Read(int64_t *values, size_t capacity, size_t *count);
+  Reader::READ_STATUS Read(double *values, size_t capacity, size_t *count);
+
+  // Number of non empty fields that couldn't be parsed and were skipped.
+  size_t Invalid() const;
+
+private:
+  Reader &reader;
+  char delimiter;
+  size_t column;
+  bool all_columns;
+
+  std::string chunk;
+  size_t position;
+  bool end_of_file;
+
+  // A field cut off by the end of the last chunk.
+  std::string carry;
+  size_t current_column;
+  size_t invalid;
+
+  template <typename T>
+  Reader::READ_STATUS ReadNumbers(T *values, size_t capacity, size_t *count);
+
+  template <typename T>
+  void Emit(const View &field, char separator, T *values, size_t *count);
+};
+
+} // End File
+
+#endif // FILE_NUMERIC_H
@@ -0,0 +1,154 @@
+#include "page_buffer.hpp"
+#include "allocator.hpp"
+
+#include <sys/mman.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace File {
+
+PageBuffer::PageBuffer(size_t alignment) :
+    data(nullptr),
+    capacity(0),
+    kind(KIND::NONE),
+    alignment(alignment < sizeof(void *) ? sizeof(void *) : alignment),
+    huge_pages(false),
+    owner(nullptr),
+    allocator(&BufferAllocator::Pooled())
+{}
+
+PageBuffer::~PageBuffer() {
+    Release();
+}
+
+void PageBuffer::SetHugePages(bool enabled) {
+    huge_pages = enabled;
+}
+
+void PageBuffer::SetAllocator(const BufferAllocator & buffer_allocator) {
+    allocator = &buffer_allocator;
+}
+
+char * PageBuffer::Reserve(size_t size) {
+    if (size <= capacity) {
+        return data;
+    }
+
+    size_t grown = capacity * 2 > size ? capacity * 2 : size;
+
+    // Mappings come in whole huge pages, so use all of the last one.
+    if (huge_pages && grown >= HUGE_PAGE_SIZE) {
+        grown = (grown + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    }
+
+    KIND grown_kind;
+    char *memory = Allocate(grown, grown_kind);
+
+    if (memory == nullptr) {
+        return nullptr;
+    }
+
+    if (capacity > 0) {
+        memcpy(memory, data, capacity);
+    }
+
+    Free(data, capacity, kind);
+
+    data = memory;
+    capacity = grown;
+    kind = grown_kind;
+    owner = allocator;
+
+    return data;
+}
+
+char * PageBuffer::Allocate(size_t & size, KIND & allocated_kind) {
+    if (huge_pages && size >= HUGE_PAGE_SIZE) {
+        void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (memory != MAP_FAILED) {
+            allocated_kind = KIND::HUGETLB;
+            return static_cast<char *>(memory);
+        }
+
+        // No reserved huge pages. Map an extra page's worth to cut a 2 MiB aligned region
+        // out of, transparent huge pages only back aligned regions.
+        memory = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (memory != MAP_FAILED) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(memory);
+            uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(static_cast<uintptr_t>(HUGE_PAGE_SIZE) - 1);
+
+            if (aligned > start) {
+                munmap(memory, aligned - start);
+            }
+
+            if (aligned + size < start + size + HUGE_PAGE_SIZE) {
+                munmap(reinterpret_cast<void *>(aligned + size), start + HUGE_PAGE_SIZE - aligned);
+            }
+
+            madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+
+            allocated_kind = KIND::MAPPED;
+            return reinterpret_cast<char *>(aligned);
+        }
+    }
+
+    // Allocators only promise 64 byte alignment.
+    if (alignment <= 64) {
+        char *memory = allocator->Allocate(size, &size);
+
+        allocated_kind = KIND::ALLOCATOR;
+
+        return memory;
+    }
+
+    void *memory = nullptr;
+
+    if (posix_memalign(&memory, alignment, size) != 0) {
+        return nullptr;
+    }
+
+    allocated_kind = KIND::HEAP;
+    return static_cast<char *>(memory);
+}
+
+void PageBuffer::Free(char * memory, size_t size, KIND memory_kind) {
+    switch (memory_kind) {
+        case KIND::HEAP:
+            free(memory);
+            break;
+        case KIND::ALLOCATOR:
+            owner->Free(memory, size);
+            break;
+        case KIND::MAPPED:
+        case KIND::HUGETLB:
+            munmap(memory, size);
+            break;
+        case KIND::NONE:
+            break;
+    }
+}
+
+void PageBuffer::Release() {
+    Free(data, capacity, kind);
+
+    data = nullptr;
+    capacity = 0;
+    kind = KIND::NONE;
+}
+
+char * PageBuffer::Data() const {
+    return data;
+}
+
+size_t PageBuffer::Capacity() const {
+    return capacity;
+}
+
+bool PageBuffer::OnHugePages() const {
+    return kind == KIND::HUGETLB;
+}
+
+} // End File
@@ -0,0 +1,72 @@
+#ifndef FILE_PAGE_BUFFER_H
+#define FILE_PAGE_BUFFER_H
+
+#include <stddef.h>
+
+namespace File
+{
+
+class BufferAllocator;
+
+// A growable buffer that can be backed by 2 MiB pages, sparing scans over multi megabyte
+// chunks most of their TLB misses.
+//
+// With huge pages on, buffers of at least one huge page are mapped with MAP_HUGETLB. When
+// no huge pages are reserved, they are mapped 2 MiB aligned with MADV_HUGEPAGE instead, so
+// transparent huge pages can back them. Smaller buffers come from the buffer allocator
+// either way.
+class PageBuffer
+{
+public:
+  static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+  explicit PageBuffer(size_t alignment = 64);
+  ~PageBuffer();
+
+  PageBuffer(const PageBuffer &) = delete;
+  PageBuffer &operator=(const PageBuffer &) = delete;
+
+  // Both take effect from the next allocation.
+  void SetHugePages(bool enabled);
+  void SetAllocator(const BufferAllocator &allocator);
+
+  // Grow to at least size bytes, keeping the contents. Returns nullptr if that fails, in
+  // which case the current buffer is kept.
+  char *Reserve(size_t size);
+
+  char *Data() const;
+  size_t Capacity() const;
+
+  // Whether the buffer is on reserved huge pages, rather than transparent ones or the heap.
+  bool OnHugePages() const;
+
+  void Release();
+
+private:
+  enum class KIND : char
+  {
+    NONE,
+    HEAP,
+    MAPPED,
+    HUGETLB,
+    ALLOCATOR
+  };
+
+  char *data;
+  size_t capacity;
+  KIND kind;
+  size_t alignment;
+  bool huge_pages;
+
+  // The allocator the current buffer came from, and the one the next comes from.
+  const BufferAllocator *owner;
+  const BufferAllocator *allocator;
+
+  // Allocate at least size bytes of the right kind, setting kind and size.
+  char *Allocate(size_t &size, KIND &kind);
+  void Free(char *memory, size_t size, KIND kind);
+};
+
+} // End File
+
+#endif // FILE_PAGE_BUFFER_H
@@ -0,0 +1,216 @@
+#include "parallel_scan.hpp"
+#include "memory_budget.hpp"
+#include "thread_pool.hpp"
+
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace File {
+
+namespace {
+
+const size_t DEFAULT_RANGE_SIZE = 1 << 20;
+const size_t READ_SIZE = 1 << 16;
+
+struct ScanState
+{
+    ScanState(Reader & reader, ThreadPool & pool, char delimiter, std::function<void(size_t, off_t, const View &)> & callback,
+              bool adaptive, size_t min_split_size, MemoryBudget * budget) :
+        reader(reader),
+        pool(pool),
+        delimiter(delimiter),
+        callback(callback),
+        adaptive(adaptive),
+        min_split_size(min_split_size),
+        budget(budget),
+        outstanding(0),
+        status(Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE),
+        windows(pool.Size())
+    {}
+
+    Reader &reader;
+    ThreadPool &pool;
+    char delimiter;
+    std::function<void(size_t, off_t, const View &)> &callback;
+    bool adaptive;
+    size_t min_split_size;
+    MemoryBudget *budget;
+
+    // Ranges submitted and not yet finished, fewer than the pool's size means idle workers.
+    std::atomic<size_t> outstanding;
+
+    std::mutex lock;
+    Reader::READ_STATUS status;
+
+    // A read window per worker, reused across its ranges.
+    std::vector<std::vector<char>> windows;
+
+    void Fail(Reader::READ_STATUS error) {
+        std::lock_guard<std::mutex> guard(lock);
+        status = error;
+    }
+
+    void Submit(off_t start, off_t stop);
+    void Run(off_t start, off_t stop);
+};
+
+void ScanState::Submit(off_t start, off_t stop) {
+    outstanding++;
+
+    pool.Submit([this, start, stop]() {
+        Run(start, stop);
+        outstanding--;
+    });
+}
+
+void ScanState::Run(off_t start, off_t stop) {
+    const size_t worker = pool.WorkerIndex();
+
+    // The window holds the file's bytes [window_offset, window_offset + filled). The first
+    // resize happens on the worker, which places the pages on its node.
+    std::vector<char> &window = windows[worker];
+    MemoryReservation reserved(budget, window.size() > READ_SIZE ? window.size() : READ_SIZE);
+
+    if (window.size() < READ_SIZE) {
+        window.resize(READ_SIZE);
+    }
+
+    off_t window_offset = start > 0 ? start - 1 : 0;
+    size_t filled = 0;
+    size_t cursor = 0;
+    size_t scanned = 0;
+    bool end_of_file = false;
+    bool aligned = start == 0;
+
+    while (true) {
+        if (scanned < filled) {
+            const char *begin = window.data();
+            const char *found = static_cast<const char *>(memchr(begin + scanned, delimiter, filled - scanned));
+
+            if (found != nullptr) {
+                size_t end = found - begin;
+
+                // Skip the tail of the record the previous range owns.
+                if (aligned) {
+                    callback(worker, window_offset + cursor, View(begin + cursor, end - cursor));
+                }
+
+                aligned = true;
+                cursor = scanned = end + 1;
+
+                // The next record belongs to the following range.
+                if (window_offset + static_cast<off_t>(cursor) >= stop) {
+                    return;
+                }
+
+                continue;
+            }
+        }
+
+        if (end_of_file) {
+            if (aligned && cursor < filled) {
+                callback(worker, window_offset + cursor, View(window.data() + cursor, filled - cursor));
+            }
+
+            return;
+        }
+
+        off_t record_offset = window_offset + cursor;
+
+        // Hand the back half of the range to an idle worker, keeping the record in progress.
+        if (adaptive && aligned && outstanding < pool.Size() && stop - record_offset > static_cast<off_t>(2 * min_split_size)) {
+            off_t middle = record_offset + (stop - record_offset) / 2;
+
+            Submit(middle, stop);
+            stop = middle;
+        }
+
+        // Slide the partial record to the front, growing the window for long records.
+        size_t remaining = filled - cursor;
+
+        memmove(window.data(), window.data() + cursor, remaining);
+
+        if (window.size() - remaining < READ_SIZE) {
+            reserved.Resize(remaining + READ_SIZE);
+            window.resize(remaining + READ_SIZE);
+        }
+
+        window_offset += cursor;
+        scanned = remaining;
+        cursor = 0;
+
+        ssize_t bytes_read = 0;
+        Reader::READ_STATUS read_status = reader.ReadAt(window.data() + remaining, READ_SIZE,
+                                                        window_offset + remaining, &bytes_read);
+
+        if (reader.StatusError(read_status)) {
+            Fail(read_status);
+            return;
+        }
+
+        filled = remaining + bytes_read;
+        end_of_file = static_cast<size_t>(bytes_read) < READ_SIZE;
+    }
+}
+
+} // End anonymous namespace
+
+ParallelScanner::ParallelScanner(size_t threads) :
+    threads(threads),
+    range_size(DEFAULT_RANGE_SIZE),
+    adaptive(false),
+    min_split_size(1 << 16),
+    pin_workers(false),
+    budget(nullptr)
+{}
+
+ParallelScanner & ParallelScanner::SetRangeSize(size_t size) {
+    range_size = size > 0 ? size : 1;
+
+    return *this;
+}
+
+ParallelScanner & ParallelScanner::SetPinWorkers(bool enabled) {
+    pin_workers = enabled;
+
+    return *this;
+}
+
+ParallelScanner & ParallelScanner::SetMemoryBudget(MemoryBudget * shared_budget) {
+    budget = shared_budget;
+
+    return *this;
+}
+
+ParallelScanner & ParallelScanner::SetAdaptiveSplitting(bool enabled, size_t min_size) {
+    adaptive = enabled;
+    min_split_size = min_size > 0 ? min_size : 1;
+
+    return *this;
+}
+
+Reader::READ_STATUS ParallelScanner::Scan(Reader & reader, char delimiter,
+                                          std::function<void(size_t, off_t, const View &)> callback) {
+    if (reader.Descriptor() == -1) {
+        return Reader::READ_STATUS::ERROR;
+    }
+
+    const off_t size = reader.Stat().st_size;
+
+    ThreadPool pool(threads, pin_workers);
+
+    ScanState scan(reader, pool, delimiter, callback, adaptive, min_split_size, budget);
+
+    for (off_t start = 0; start < size; start += range_size) {
+        scan.Submit(start, start + static_cast<off_t>(range_size) < size ? start + range_size : size);
+    }
+
+    pool.Wait();
+
+    return scan.status;
+}
+
+} // End File
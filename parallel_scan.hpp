@@ -0,0 +1,59 @@
+#ifndef FILE_PARALLEL_SCAN_H
+#define FILE_PARALLEL_SCAN_H
+
+#include <sys/types.h>
+#include <functional>
+
+#include "file.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+class MemoryBudget;
+
+// Scans a file of delimited records with several threads.
+//
+// The file is cut into ranges that are run as tasks on a work stealing pool, so a worker
+// stuck in an expensive region doesn't hold the others up: they keep taking the remaining
+// ranges. With adaptive splitting, a worker that notices idle workers also hands off the
+// back half of the range it's in, so a single slow range is shared out too.
+//
+// A record belongs to the range it starts in. Records are views without the delimiter and
+// the callback is called concurrently, with the index of the worker and the record's offset.
+class ParallelScanner
+{
+public:
+  // Zero threads means one per hardware thread.
+  explicit ParallelScanner(size_t threads = 0);
+
+  // Size of the ranges the file is cut into.
+  ParallelScanner &SetRangeSize(size_t size);
+
+  // Split ranges in flight when workers go idle, down to ranges of min_size.
+  ParallelScanner &SetAdaptiveSplitting(bool enabled, size_t min_size = 1 << 16);
+
+  // Pin workers to CPUs, one NUMA node at a time. Each worker's read buffer is allocated and
+  // first touched by the worker itself, so it lives on the node the range is processed on.
+  ParallelScanner &SetPinWorkers(bool enabled);
+
+  // Count each worker's read window against a budget shared with other stages while the
+  // worker scans a range. Workers wait for room before starting a range.
+  ParallelScanner &SetMemoryBudget(MemoryBudget *budget);
+
+  // Scan the reader's file. Reads go through ReadAt, so the reader's offset is left alone.
+  Reader::READ_STATUS Scan(Reader &reader, char delimiter,
+                           std::function<void(size_t, off_t, const View &)> callback);
+
+private:
+  size_t threads;
+  size_t range_size;
+  bool adaptive;
+  size_t min_split_size;
+  bool pin_workers;
+  MemoryBudget *budget;
+};
+
+} // End File
+
+#endif // FILE_PARALLEL_SCAN_H
@@ -0,0 +1,644 @@
+#ifndef FILE_PIPELINE_H
+#define FILE_PIPELINE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "allocator.hpp"
+#include "file.hpp"
+#include "memory_budget.hpp"
+#include "range.hpp"
+#include "thread_pool.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+// Composable read pipelines:
+//
+// File::From(reader) | File::Split('\n') | File::Filter(keep) | File::Map(parse) | File::ForEach(emit);
+//
+// Every stage wraps the one after it, so the whole pipeline compiles down to a single loop
+// over the reader's chunks with no intermediate strings. Records are views into the
+// reader's buffer and are only valid until the stage they're passed to returns.
+//
+// Adding the sink runs the pipeline and returns the status of the last read. Stages can
+// allocate records into ChunkArena(), which is reset once a chunk has gone all the way
+// through.
+
+// Reads the file in chunks of the reader's read size.
+class Source
+{
+public:
+  explicit Source(Reader &reader) : reader(&reader) {}
+
+  template <typename Next>
+  Reader::READ_STATUS Run(Next next) const
+  {
+    ChunkRange chunks(*reader);
+
+    Arena &arena = ChunkArena();
+
+    for (const View &chunk : chunks) {
+      next(chunk);
+      arena.Reset();
+    }
+
+    next.Finish();
+    arena.Reset();
+
+    return chunks.Status();
+  }
+
+private:
+  Reader *reader;
+};
+
+inline Source From(Reader &reader)
+{
+  return Source(reader);
+}
+
+// A source followed by a stage.
+template <typename Upstream, typename Stage>
+class Chain
+{
+public:
+  Chain(const Upstream &upstream, const Stage &stage) : upstream(upstream), stage(stage) {}
+
+  template <typename Next>
+  Reader::READ_STATUS Run(Next next) const
+  {
+    return upstream.Run(typename Stage::template Consumer<Next>(stage, next));
+  }
+
+private:
+  Upstream upstream;
+  Stage stage;
+};
+
+// Splits chunks into records on a delimiter, without the delimiter. A last record without
+// one is still passed on.
+class SplitStage
+{
+public:
+  explicit SplitStage(char delimiter) : delimiter(delimiter) {}
+
+  template <typename Next>
+  class Consumer
+  {
+  public:
+    Consumer(const SplitStage &stage, Next next) : delimiter(stage.delimiter), next(next) {}
+
+    void operator()(const View &chunk)
+    {
+      const char *begin = chunk.begin();
+      const char *end = chunk.end();
+      const char *found;
+
+      while ((found = static_cast<const char *>(memchr(begin, delimiter, end - begin))) != nullptr) {
+        // Only records straddling chunks are copied.
+        if (carry.empty()) {
+          next(View(begin, found - begin));
+        } else {
+          carry.append(begin, found - begin);
+          next(View(carry));
+          carry.clear();
+        }
+
+        begin = found + 1;
+      }
+
+      carry.append(begin, end - begin);
+    }
+
+    void Finish()
+    {
+      if (!carry.empty()) {
+        next(View(carry));
+        carry.clear();
+      }
+
+      next.Finish();
+    }
+
+  private:
+    char delimiter;
+    std::string carry;
+    Next next;
+  };
+
+private:
+  char delimiter;
+};
+
+inline SplitStage Split(char delimiter)
+{
+  return SplitStage(delimiter);
+}
+
+// Passes on the records the predicate accepts.
+template <typename Predicate>
+class FilterStage
+{
+public:
+  explicit FilterStage(Predicate predicate) : predicate(predicate) {}
+
+  template <typename Next>
+  class Consumer
+  {
+  public:
+    Consumer(const FilterStage &stage, Next next) : predicate(stage.predicate), next(next) {}
+
+    template <typename T>
+    void operator()(const T &record)
+    {
+      if (predicate(record)) {
+        next(record);
+      }
+    }
+
+    void Finish() { next.Finish(); }
+
+  private:
+    Predicate predicate;
+    Next next;
+  };
+
+private:
+  Predicate predicate;
+};
+
+template <typename Predicate>
+FilterStage<Predicate> Filter(Predicate predicate)
+{
+  return FilterStage<Predicate>(predicate);
+}
+
+// Passes on the function's result for every record.
+template <typename Function>
+class MapStage
+{
+public:
+  explicit MapStage(Function function) : function(function) {}
+
+  template <typename Next>
+  class Consumer
+  {
+  public:
+    Consumer(const MapStage &stage, Next next) : function(stage.function), next(next) {}
+
+    template <typename T>
+    void operator()(const T &record)
+    {
+      next(function(record));
+    }
+
+    void Finish() { next.Finish(); }
+
+  private:
+    Function function;
+    Next next;
+  };
+
+private:
+  Function function;
+};
+
+template <typename Function>
+MapStage<Function> Map(Function function)
+{
+  return MapStage<Function>(function);
+}
+
+// Runs the stages after it on a thread pool, over batches of the records it's given. The
+// batches are copied out of the reader's buffer and handed to the pool. Reading only waits
+// once every worker has a couple of batches queued, and then only for the next to finish.
+//
+// Everything after it runs concurrently, so those stages must not keep state, the sink
+// must be thread safe, and records arrive in no particular order.
+//
+// With a memory budget, every batch handed to the pool is counted against it until a worker
+// is done with it, and reading stalls while the budget is used up.
+class ParallelStage
+{
+public:
+  ParallelStage(size_t threads, size_t batch_size, MemoryBudget *budget) :
+    threads(threads),
+    batch_size(batch_size),
+    budget(budget)
+  {}
+
+  template <typename Next>
+  class Consumer
+  {
+  public:
+    Consumer(const ParallelStage &stage, Next next) :
+      state(std::make_shared<State>(stage.threads, stage.batch_size, stage.budget)),
+      next(next)
+    {}
+
+    void operator()(const View &record)
+    {
+      Batch &batch = *state->batch;
+
+      batch.records.push_back(std::make_pair(batch.bytes.size(), record.size()));
+      batch.bytes.append(record.data(), record.size());
+
+      if (batch.records.size() >= state->batch_size) {
+        Dispatch();
+      }
+    }
+
+    void Finish()
+    {
+      if (!state->batch->records.empty()) {
+        Dispatch();
+      }
+
+      state->pool.Wait();
+      next.Finish();
+    }
+
+  private:
+    struct Batch
+    {
+      std::string bytes;
+      std::vector<std::pair<size_t, size_t>> records;
+    };
+
+    struct State
+    {
+      State(size_t threads, size_t batch_size, MemoryBudget *budget) :
+        in_flight(0),
+        pool(threads),
+        batch(std::make_shared<Batch>()),
+        batch_size(batch_size > 0 ? batch_size : 1),
+        budget(budget)
+      {}
+
+      // Batches submitted and not yet finished. Declared before the pool, which finishes
+      // its tasks on destruction, so they outlive it.
+      std::mutex lock;
+      std::condition_variable finished;
+      size_t in_flight;
+
+      ThreadPool pool;
+      std::shared_ptr<Batch> batch;
+      size_t batch_size;
+      MemoryBudget *budget;
+    };
+
+    std::shared_ptr<State> state;
+    Next next;
+
+    void Dispatch()
+    {
+      std::shared_ptr<Batch> batch = state->batch;
+      Next worker = next;
+      MemoryBudget *budget = state->budget;
+      State *shared = state.get();
+
+      // Bound the memory in flight to a couple of batches per worker, waiting only for a
+      // slot rather than for every batch to drain.
+      {
+        std::unique_lock<std::mutex> guard(shared->lock);
+        const size_t limit = shared->pool.Size() * 2;
+
+        shared->finished.wait(guard, [shared, limit]() { return shared->in_flight < limit; });
+        shared->in_flight++;
+      }
+
+      if (budget != nullptr) {
+        budget->Reserve(batch->bytes.size());
+      }
+
+      state->pool.Submit([batch, worker, budget, shared]() mutable {
+        for (const std::pair<size_t, size_t> &record : batch->records) {
+          worker(View(batch->bytes.data() + record.first, record.second));
+        }
+
+        ChunkArena().Reset();
+
+        if (budget != nullptr) {
+          budget->Release(batch->bytes.size());
+        }
+
+        std::lock_guard<std::mutex> guard(shared->lock);
+        shared->in_flight--;
+        shared->finished.notify_one();
+      });
+
+      state->batch = std::make_shared<Batch>();
+    }
+  };
+
+private:
+  size_t threads;
+  size_t batch_size;
+  MemoryBudget *budget;
+};
+
+// Zero threads means one per hardware thread.
+inline ParallelStage Parallel(size_t threads = 0, size_t batch_size = 4096, MemoryBudget *budget = nullptr)
+{
+  return ParallelStage(threads, batch_size, budget);
+}
+
+// Maps records on a thread pool while keeping their order. Records are copied into
+// numbered batches, mapped by the pool's workers, and passed on in sequence from the
+// pipeline's own thread, so the stages after it and the sink need no locking.
+//
+// At most max_batches are in flight, finished batches wait in a reorder buffer of that
+// size until the batches before them are done. Zero means four per thread. With a memory
+// budget, a batch's input bytes count against it until its results have been passed on,
+// and are kept until then too, so the function may return views into its record.
+template <typename Function>
+class OrderedMapStage
+{
+public:
+  OrderedMapStage(Function function, size_t threads, size_t batch_size, size_t max_batches, MemoryBudget *budget) :
+    function(function),
+    threads(threads),
+    batch_size(batch_size),
+    max_batches(max_batches),
+    budget(budget)
+  {}
+
+  template <typename Next>
+  class Consumer
+  {
+  public:
+    typedef typename std::decay<decltype(std::declval<Function &>()(std::declval<const View &>()))>::type Result;
+
+    Consumer(const OrderedMapStage &stage, Next next) :
+      state(std::make_shared<State>(stage)),
+      next(next)
+    {}
+
+    void operator()(const View &record)
+    {
+      Batch &batch = *state->batch;
+
+      batch.records.push_back(std::make_pair(batch.bytes.size(), record.size()));
+      batch.bytes.append(record.data(), record.size());
+
+      if (batch.records.size() >= state->batch_size) {
+        Dispatch();
+      }
+    }
+
+    void Finish()
+    {
+      if (!state->batch->records.empty()) {
+        Dispatch();
+      }
+
+      while (state->emitted < state->submitted) {
+        Emit();
+      }
+
+      next.Finish();
+    }
+
+  private:
+    struct Batch
+    {
+      std::string bytes;
+      std::vector<std::pair<size_t, size_t>> records;
+    };
+
+    struct Slot
+    {
+      Slot() : ready(false), bytes(0) {}
+
+      bool ready;
+      std::vector<Result> results;
+
+      // Kept until the results are passed on, they may be views into its records.
+      std::shared_ptr<Batch> batch;
+
+      // Reserved from the budget for the batch.
+      size_t bytes;
+    };
+
+    struct State
+    {
+      explicit State(const OrderedMapStage &stage) :
+        function(stage.function),
+        batch(std::make_shared<Batch>()),
+        batch_size(stage.batch_size > 0 ? stage.batch_size : 1),
+        submitted(0),
+        emitted(0),
+        budget(stage.budget),
+        pool(stage.threads)
+      {
+        slots.resize(stage.max_batches > 0 ? stage.max_batches : pool.Size() * 4);
+      }
+
+      Function function;
+
+      std::mutex lock;
+      std::condition_variable batch_done;
+
+      std::shared_ptr<Batch> batch;
+      size_t batch_size;
+
+      // The reorder buffer, batch n lands in slot n % slots.size().
+      std::vector<Slot> slots;
+      uint64_t submitted;
+      uint64_t emitted;
+
+      MemoryBudget *budget;
+
+      // Declared after everything the workers touch, so it's joined first.
+      ThreadPool pool;
+    };
+
+    std::shared_ptr<State> state;
+    Next next;
+
+    void Dispatch()
+    {
+      // Make room by passing on the oldest batch.
+      if (state->submitted - state->emitted >= state->slots.size()) {
+        Emit();
+      }
+
+      std::shared_ptr<Batch> batch = state->batch;
+
+      if (state->budget != nullptr) {
+        // Only passing on finished batches frees the budget, so do that rather than block
+        // while any are in flight.
+        while (!state->budget->TryReserve(batch->bytes.size())) {
+          if (state->emitted == state->submitted) {
+            state->budget->Reserve(batch->bytes.size());
+            break;
+          }
+
+          Emit();
+        }
+      }
+
+      uint64_t sequence = state->submitted++;
+      State *shared = state.get();
+
+      {
+        std::lock_guard<std::mutex> guard(state->lock);
+        Slot &slot = state->slots[sequence % state->slots.size()];
+        slot.batch = batch;
+        slot.bytes = batch->bytes.size();
+      }
+
+      state->pool.Submit([shared, batch, sequence]() {
+        std::vector<Result> results;
+        results.reserve(batch->records.size());
+
+        for (const std::pair<size_t, size_t> &record : batch->records) {
+          results.push_back(shared->function(View(batch->bytes.data() + record.first, record.second)));
+        }
+
+        std::lock_guard<std::mutex> guard(shared->lock);
+
+        Slot &slot = shared->slots[sequence % shared->slots.size()];
+        slot.results.swap(results);
+        slot.ready = true;
+
+        shared->batch_done.notify_all();
+      });
+
+      state->batch = std::make_shared<Batch>();
+
+      // Pass on whatever is already done, without waiting.
+      while (state->emitted < state->submitted && Ready(state->emitted)) {
+        Emit();
+      }
+    }
+
+    bool Ready(uint64_t sequence)
+    {
+      std::lock_guard<std::mutex> guard(state->lock);
+      return state->slots[sequence % state->slots.size()].ready;
+    }
+
+    // Wait for the oldest batch in flight and pass its results on.
+    void Emit()
+    {
+      std::vector<Result> results;
+      std::shared_ptr<Batch> batch;
+      size_t bytes;
+
+      {
+        std::unique_lock<std::mutex> guard(state->lock);
+        Slot &slot = state->slots[state->emitted % state->slots.size()];
+
+        state->batch_done.wait(guard, [&slot]() {
+          return slot.ready;
+        });
+
+        results.swap(slot.results);
+        batch.swap(slot.batch);
+        slot.ready = false;
+        bytes = slot.bytes;
+      }
+
+      state->emitted++;
+
+      for (const Result &result : results) {
+        next(result);
+      }
+
+      results.clear();
+      batch.reset();
+
+      if (state->budget != nullptr) {
+        state->budget->Release(bytes);
+      }
+    }
+  };
+
+private:
+  Function function;
+  size_t threads;
+  size_t batch_size;
+  size_t max_batches;
+  MemoryBudget *budget;
+};
+
+template <typename Function>
+OrderedMapStage<Function> OrderedMap(Function function, size_t threads = 0, size_t batch_size = 1024,
+                                     size_t max_batches = 0, MemoryBudget *budget = nullptr)
+{
+  return OrderedMapStage<Function>(function, threads, batch_size, max_batches, budget);
+}
+
+// Ends the pipeline, calling the function for every record.
+template <typename Function>
+class ForEachStage
+{
+public:
+  explicit ForEachStage(Function function) : function(function) {}
+
+  class Consumer
+  {
+  public:
+    explicit Consumer(Function function) : function(function) {}
+
+    template <typename T>
+    void operator()(const T &record)
+    {
+      function(record);
+    }
+
+    void Finish() {}
+
+  private:
+    Function function;
+  };
+
+  Consumer Bind() const { return Consumer(function); }
+
+private:
+  Function function;
+};
+
+template <typename Function>
+ForEachStage<Function> ForEach(Function function)
+{
+  return ForEachStage<Function>(function);
+}
+
+template <typename Stage>
+Chain<Source, Stage> operator|(const Source &source, const Stage &stage)
+{
+  return Chain<Source, Stage>(source, stage);
+}
+
+template <typename Upstream, typename Last, typename Stage>
+Chain<Chain<Upstream, Last>, Stage> operator|(const Chain<Upstream, Last> &chain, const Stage &stage)
+{
+  return Chain<Chain<Upstream, Last>, Stage>(chain, stage);
+}
+
+template <typename Function>
+Reader::READ_STATUS operator|(const Source &source, const ForEachStage<Function> &sink)
+{
+  return source.Run(sink.Bind());
+}
+
+template <typename Upstream, typename Last, typename Function>
+Reader::READ_STATUS operator|(const Chain<Upstream, Last> &chain, const ForEachStage<Function> &sink)
+{
+  return chain.Run(sink.Bind());
+}
+
+} // End File
+
+#endif // FILE_PIPELINE_H
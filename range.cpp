@@ -0,0 +1,161 @@
+#include "range.hpp"
+
+#include <string.h>
+
+#if __cplusplus >= 202002L
+#include <ranges>
+
+static_assert(std::ranges::input_range<File::ChunkRange>, "ChunkRange must be an input range");
+static_assert(std::ranges::input_range<File::LineRange>, "LineRange must be an input range");
+#endif
+
+namespace File {
+
+namespace {
+
+size_t ChunkSize(size_t read_size, const struct stat & file_stat) {
+    // A zero read size would never reach the end of the file.
+    return read_size > 0 ? read_size : file_stat.st_blksize;
+}
+
+} // End anonymous namespace
+
+ChunkRange::ChunkRange(Reader & reader) :
+    reader(reader),
+    status(Reader::READ_STATUS::OK),
+    started(false),
+    done(false)
+{}
+
+ChunkRange::iterator ChunkRange::begin() {
+    if (!started) {
+        started = true;
+        Next();
+    }
+
+    return iterator(this);
+}
+
+ChunkRange::iterator ChunkRange::end() {
+    return iterator();
+}
+
+Reader::READ_STATUS ChunkRange::Status() const {
+    return status;
+}
+
+void ChunkRange::Next() {
+    // The previous read already hit the end.
+    if (reader.StatusEndOfFile(status) || reader.StatusError(status)) {
+        done = true;
+        return;
+    }
+
+    size_t size = ChunkSize(reader.read_size, reader.file_stat);
+    char *buffer = reader.ReserveBuffer(size);
+    ssize_t bytes_read = 0;
+
+    if (buffer == nullptr) {
+        status = Reader::READ_STATUS::ERROR;
+        done = true;
+        return;
+    }
+
+    status = reader.Read(buffer, size, &bytes_read);
+
+    if (reader.StatusError(status) || bytes_read == 0) {
+        done = true;
+        return;
+    }
+
+    current = View(buffer, bytes_read);
+}
+
+LineRange::LineRange(Reader & reader) :
+    reader(reader),
+    status(Reader::READ_STATUS::OK),
+    started(false),
+    done(false),
+    cursor(0),
+    filled(0),
+    end_of_file(false)
+{}
+
+LineRange::iterator LineRange::begin() {
+    if (!started) {
+        started = true;
+        Next();
+    }
+
+    return iterator(this);
+}
+
+LineRange::iterator LineRange::end() {
+    return iterator();
+}
+
+Reader::READ_STATUS LineRange::Status() const {
+    return status;
+}
+
+void LineRange::Next() {
+    size_t scanned = cursor;
+
+    for (;;) {
+        char *buffer = reader.buffer.Data();
+
+        if (filled > scanned) {
+            const char *newline = static_cast<const char *>(memchr(buffer + scanned, '\n', filled - scanned));
+
+            if (newline != nullptr) {
+                current = View(buffer + cursor, newline - (buffer + cursor));
+                cursor = newline + 1 - buffer;
+                return;
+            }
+        }
+
+        if (end_of_file) {
+            if (cursor < filled) {
+                current = View(buffer + cursor, filled - cursor);
+                cursor = filled;
+                return;
+            }
+
+            done = true;
+            return;
+        }
+
+        // Slide the partial line to the front and read more after it.
+        size_t remaining = filled - cursor;
+
+        if (cursor > 0 && remaining > 0) {
+            memmove(buffer, buffer + cursor, remaining);
+        }
+
+        size_t size = ChunkSize(reader.read_size, reader.file_stat);
+
+        buffer = reader.ReserveBuffer(remaining + size);
+
+        if (buffer == nullptr) {
+            status = Reader::READ_STATUS::ERROR;
+            done = true;
+            return;
+        }
+
+        ssize_t bytes_read = 0;
+
+        status = reader.Read(buffer + remaining, size, &bytes_read);
+
+        if (reader.StatusError(status)) {
+            done = true;
+            return;
+        }
+
+        scanned = remaining;
+        cursor = 0;
+        filled = remaining + bytes_read;
+        end_of_file = reader.StatusEndOfFile(status) || bytes_read == 0;
+    }
+}
+
+} // End File
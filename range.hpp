@@ -0,0 +1,118 @@
+#ifndef FILE_RANGE_H
+#define FILE_RANGE_H
+
+#include <stddef.h>
+#include <iterator>
+
+#include "file.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+// Input ranges over a reader, so files can be consumed with range-for and standard
+// algorithms. Both hand out views into the reader's scratch buffer, which are only valid
+// until the iterator is advanced. Only one range should be iterating a reader at a time.
+//
+// for (const File::View & line : File::LineRange(reader)) { ... }
+
+template <typename Range>
+class RangeIterator
+{
+public:
+  typedef std::input_iterator_tag iterator_category;
+  typedef View value_type;
+  typedef ptrdiff_t difference_type;
+  typedef const View *pointer;
+  typedef const View &reference;
+
+  RangeIterator() : range(nullptr) {}
+  explicit RangeIterator(Range *range) : range(range) {}
+
+  const View &operator*() const { return range->current; }
+  const View *operator->() const { return &range->current; }
+
+  RangeIterator &operator++()
+  {
+    range->Next();
+    return *this;
+  }
+
+  // Input iterators share their range, so the copy sees the advanced position too.
+  RangeIterator operator++(int)
+  {
+    RangeIterator previous = *this;
+    range->Next();
+    return previous;
+  }
+
+  bool operator==(const RangeIterator &other) const { return Done() == other.Done(); }
+  bool operator!=(const RangeIterator &other) const { return Done() != other.Done(); }
+
+private:
+  Range *range;
+
+  bool Done() const { return range == nullptr || range->done; }
+};
+
+// The file in chunks of the reader's read size.
+class ChunkRange
+{
+public:
+  typedef RangeIterator<ChunkRange> iterator;
+
+  explicit ChunkRange(Reader &reader);
+
+  // Reads the first chunk.
+  iterator begin();
+  iterator end();
+
+  // The status of the last read, to tell the end of the file from an error.
+  Reader::READ_STATUS Status() const;
+
+private:
+  Reader &reader;
+  View current;
+  Reader::READ_STATUS status;
+  bool started;
+  bool done;
+
+  void Next();
+
+  friend class RangeIterator<ChunkRange>;
+};
+
+// The file line by line, without the terminating newline. A last line without a newline is
+// still handed out. Lines longer than the read size grow the reader's buffer to fit.
+class LineRange
+{
+public:
+  typedef RangeIterator<LineRange> iterator;
+
+  explicit LineRange(Reader &reader);
+
+  iterator begin();
+  iterator end();
+
+  Reader::READ_STATUS Status() const;
+
+private:
+  Reader &reader;
+  View current;
+  Reader::READ_STATUS status;
+  bool started;
+  bool done;
+
+  // The unconsumed bytes are buffer[cursor, filled).
+  size_t cursor;
+  size_t filled;
+  bool end_of_file;
+
+  void Next();
+
+  friend class RangeIterator<LineRange>;
+};
+
+} // End File
+
+#endif // FILE_RANGE_H
@@ -0,0 +1,88 @@
+#include "record_reader.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILE_RECORD_X86 1
+#endif
+
+namespace File {
+
+namespace {
+
+typedef void (*SwapFunction)(char *, size_t, size_t);
+
+void ByteSwapScalar(char * data, size_t count, size_t width) {
+    for (size_t i = 0; i < count; i++, data += width) {
+        if (width == 2) {
+            uint16_t value;
+            memcpy(&value, data, width);
+            value = __builtin_bswap16(value);
+            memcpy(data, &value, width);
+        } else if (width == 4) {
+            uint32_t value;
+            memcpy(&value, data, width);
+            value = __builtin_bswap32(value);
+            memcpy(data, &value, width);
+        } else {
+            uint64_t value;
+            memcpy(&value, data, width);
+            value = __builtin_bswap64(value);
+            memcpy(data, &value, width);
+        }
+    }
+}
+
+#ifdef FILE_RECORD_X86
+
+// Reverse the bytes of every value in a 16 byte block with a single shuffle.
+__attribute__((target("ssse3")))
+void ByteSwapSsse3(char * data, size_t count, size_t width) {
+    __m128i shuffle;
+
+    if (width == 2) {
+        shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    } else if (width == 4) {
+        shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    } else {
+        shuffle = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+
+    const size_t per_block = 16 / width;
+    size_t i = 0;
+
+    for (; i + per_block <= count; i += per_block, data += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data), _mm_shuffle_epi8(block, shuffle));
+    }
+
+    ByteSwapScalar(data, count - i, width);
+}
+
+#endif
+
+SwapFunction SelectByteSwap() {
+#ifdef FILE_RECORD_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("ssse3")) {
+        return ByteSwapSsse3;
+    }
+#endif
+
+    return ByteSwapScalar;
+}
+
+} // End anonymous namespace
+
+void ByteSwap(void * data, size_t count, size_t width) {
+    static const SwapFunction swap = SelectByteSwap();
+
+    if (width == 2 || width == 4 || width == 8) {
+        swap(static_cast<char *>(data), count, width);
+    }
+}
+
+} // End File
@@ -0,0 +1,212 @@
+#ifndef FILE_RECORD_READER_H
+#define FILE_RECORD_READER_H
+
+#include <sys/mman.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <type_traits>
+#include <functional>
+
+#include "file.hpp"
+#include "page_buffer.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+// Reverse the bytes of count values of width 2, 4 or 8, vectorized with SSSE3 when available.
+void ByteSwap(void *data, size_t count, size_t width);
+
+// Reads a file made of fixed size binary records, handing out batches of whole records.
+//
+// Batches are always a multiple of sizeof(T) and properly aligned. In mapped mode they point
+// straight into a read only mapping of the file, so no copy is made at all, otherwise they
+// point into a buffer owned by the reader that is reused for every batch.
+template <typename T>
+class RecordReader
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Records must be trivially copyable");
+
+public:
+  explicit RecordReader(Reader &reader) :
+    reader(reader),
+    batch_size(DEFAULT_BATCH_BYTES / sizeof(T) > 0 ? DEFAULT_BATCH_BYTES / sizeof(T) : 1),
+    mapped(false),
+    byte_swap(false),
+    trailing(0),
+    huge_pages(false),
+    buffer(alignof(T) > BUFFER_ALIGNMENT ? alignof(T) : BUFFER_ALIGNMENT)
+  {}
+
+  // Number of records handed out per batch.
+  RecordReader &SetBatchSize(size_t records)
+  {
+    batch_size = records > 0 ? records : 1;
+
+    return *this;
+  }
+
+  // Hand out views into a mapping of the whole file rather than copying into a buffer.
+  RecordReader &SetMapped(bool enabled)
+  {
+    mapped = enabled;
+
+    return *this;
+  }
+
+  // Back the batch buffer with 2 MiB pages when it's at least that big, and ask for
+  // transparent huge pages on the mapping in mapped mode, where the kernel supports them
+  // for file mappings.
+  RecordReader &SetHugePages(bool enabled)
+  {
+    huge_pages = enabled;
+    buffer.Release();
+    buffer.SetHugePages(enabled);
+
+    return *this;
+  }
+
+  // Convert every record from the opposite endianness.
+  RecordReader &SetByteSwap(bool enabled)
+  {
+    static_assert(std::is_arithmetic<T>::value, "Byte swapping needs an arithmetic record type");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "Unsupported record width");
+
+    byte_swap = enabled && sizeof(T) > 1;
+
+    return *this;
+  }
+
+  // Read every record, batch by batch. Bytes at the end that don't make a whole record are
+  // skipped, see Trailing.
+  Reader::READ_STATUS Read(std::function<void(Span<const T>)> callback)
+  {
+    trailing = 0;
+
+    return mapped ? ReadMapped(callback) : ReadCopied(callback);
+  }
+
+  // Size of the incomplete record at the end of the file, if there was one.
+  size_t Trailing() const
+  {
+    return trailing;
+  }
+
+private:
+  static const size_t DEFAULT_BATCH_BYTES = 1 << 16;
+  static const size_t BUFFER_ALIGNMENT = 64;
+
+  Reader &reader;
+  size_t batch_size;
+  bool mapped;
+  bool byte_swap;
+  size_t trailing;
+  bool huge_pages;
+  PageBuffer buffer;
+
+  // Grows the buffer if the batch size was raised since it was allocated.
+  T *Buffer()
+  {
+    return reinterpret_cast<T *>(buffer.Reserve(batch_size * sizeof(T)));
+  }
+
+  Reader::READ_STATUS ReadCopied(std::function<void(Span<const T>)> &callback)
+  {
+    T *records = Buffer();
+
+    if (records == nullptr) {
+      return Reader::READ_STATUS::ERROR;
+    }
+
+    char *bytes = reinterpret_cast<char *>(records);
+    const size_t capacity = batch_size * sizeof(T);
+
+    while (true) {
+      ssize_t bytes_read = 0;
+      Reader::READ_STATUS status = reader.Read(bytes, capacity, &bytes_read);
+
+      if (reader.StatusError(status)) {
+        return status;
+      }
+
+      size_t count = bytes_read / sizeof(T);
+
+      if (count > 0) {
+        if (byte_swap) {
+          ByteSwap(records, count, sizeof(T));
+        }
+
+        callback(Span<const T>(records, count));
+      }
+
+      // Only the final read of the file comes up short.
+      if (reader.StatusEndOfFile(status) || static_cast<size_t>(bytes_read) < capacity) {
+        trailing = bytes_read % sizeof(T);
+
+        return Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+      }
+    }
+  }
+
+  Reader::READ_STATUS ReadMapped(std::function<void(Span<const T>)> &callback)
+  {
+    struct stat file_stat;
+
+    if (fstat(reader.Descriptor(), &file_stat) == -1) {
+      return Reader::READ_STATUS::ERROR;
+    }
+
+    const size_t size = file_stat.st_size;
+    const size_t count = size / sizeof(T);
+
+    trailing = size % sizeof(T);
+
+    if (count == 0) {
+      return Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+    }
+
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, reader.Descriptor(), 0);
+
+    if (mapping == MAP_FAILED) {
+      return Reader::READ_STATUS::ERROR;
+    }
+
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    if (huge_pages) {
+      madvise(mapping, size, MADV_HUGEPAGE);
+    }
+
+    // The mapping is page aligned and sizeof(T) is a multiple of alignof(T), so every
+    // record in it is aligned.
+    const T *records = static_cast<const T *>(mapping);
+    T *swapped = byte_swap ? Buffer() : nullptr;
+    Reader::READ_STATUS status = Reader::READ_STATUS::OK | Reader::READ_STATUS::END_OF_FILE;
+
+    if (byte_swap && swapped == nullptr) {
+      status = Reader::READ_STATUS::ERROR;
+    }
+
+    for (size_t first = 0; first < count && !reader.StatusError(status); first += batch_size) {
+      size_t batch = count - first < batch_size ? count - first : batch_size;
+
+      if (swapped != nullptr) {
+        // Swapping can't happen in place on a read only mapping.
+        memcpy(swapped, records + first, batch * sizeof(T));
+        ByteSwap(swapped, batch, sizeof(T));
+        callback(Span<const T>(swapped, batch));
+      } else {
+        callback(Span<const T>(records + first, batch));
+      }
+    }
+
+    munmap(mapping, size);
+
+    return status;
+  }
+};
+
+} // End File
+
+#endif // FILE_RECORD_READER_H
@@ -0,0 +1,763 @@
+#include "regex.hpp"
+#include "lines.hpp"
+
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+
+namespace File {
+
+namespace {
+
+// Bounds for {n,m} and for the DFA cache, which is flushed and rebuilt once it's full.
+const int MAX_REPEAT = 1000;
+const size_t MAX_DFA_STATES = 4096;
+
+const std::string &Longer(const std::string & a, const std::string & b) {
+    return b.size() > a.size() ? b : a;
+}
+
+} // End anonymous namespace
+
+Regex::Regex(const std::string & pattern) :
+    valid(false),
+    literal_searcher(""),
+    start(-1),
+    generation(0)
+{
+    Node root;
+    size_t position = 0;
+
+    if (!ParseAlternation(pattern, position, root) || position != pattern.size()) {
+        return;
+    }
+
+    literal = Literal(root);
+    literal_searcher = Searcher(literal);
+
+    Dangling dangling;
+    start = Compile(root, dangling);
+    Patch(dangling, AddState(NODE_TYPE::MATCH));
+
+    valid = start >= 0;
+
+    ResetDfa();
+}
+
+bool Regex::Valid() const {
+    return valid;
+}
+
+const std::string & Regex::RequiredLiteral() const {
+    return literal;
+}
+
+bool Regex::ParseAlternation(const std::string & pattern, size_t & position, Node & node) {
+    if (!ParseConcatenation(pattern, position, node)) {
+        return false;
+    }
+
+    if (position >= pattern.size() || pattern[position] != '|') {
+        return true;
+    }
+
+    Node alternation;
+    alternation.type = NODE_TYPE::ALTERNATE;
+    alternation.children.push_back(std::move(node));
+
+    while (position < pattern.size() && pattern[position] == '|') {
+        position++;
+
+        Node branch;
+
+        if (!ParseConcatenation(pattern, position, branch)) {
+            return false;
+        }
+
+        alternation.children.push_back(std::move(branch));
+    }
+
+    node = std::move(alternation);
+
+    return true;
+}
+
+bool Regex::ParseConcatenation(const std::string & pattern, size_t & position, Node & node) {
+    node.type = NODE_TYPE::CONCAT;
+
+    while (position < pattern.size() && pattern[position] != '|' && pattern[position] != ')') {
+        Node child;
+
+        if (!ParseRepetition(pattern, position, child)) {
+            return false;
+        }
+
+        node.children.push_back(std::move(child));
+    }
+
+    return true;
+}
+
+bool Regex::ParseRepetition(const std::string & pattern, size_t & position, Node & node) {
+    if (!ParseAtom(pattern, position, node)) {
+        return false;
+    }
+
+    while (position < pattern.size()) {
+        int min = 0;
+        int max = -1;
+        char c = pattern[position];
+
+        if (c == '*') {
+            position++;
+        } else if (c == '+') {
+            min = 1;
+            position++;
+        } else if (c == '?') {
+            max = 1;
+            position++;
+        } else if (c == '{') {
+            size_t cursor = position + 1;
+            size_t digits_start = cursor;
+
+            min = 0;
+
+            while (cursor < pattern.size() && isdigit(static_cast<unsigned char>(pattern[cursor])) && min <= MAX_REPEAT) {
+                min = min * 10 + (pattern[cursor++] - '0');
+            }
+
+            if (cursor == digits_start) {
+                return false;
+            }
+
+            max = min;
+
+            if (cursor < pattern.size() && pattern[cursor] == ',') {
+                cursor++;
+                max = -1;
+
+                if (cursor < pattern.size() && isdigit(static_cast<unsigned char>(pattern[cursor]))) {
+                    max = 0;
+
+                    while (cursor < pattern.size() && isdigit(static_cast<unsigned char>(pattern[cursor])) && max <= MAX_REPEAT) {
+                        max = max * 10 + (pattern[cursor++] - '0');
+                    }
+                }
+            }
+
+            if (cursor >= pattern.size() || pattern[cursor] != '}' || min > MAX_REPEAT || max > MAX_REPEAT || (max >= 0 && max < min)) {
+                return false;
+            }
+
+            position = cursor + 1;
+        } else {
+            break;
+        }
+
+        Node repeat;
+        repeat.type = NODE_TYPE::REPEAT;
+        repeat.min = min;
+        repeat.max = max;
+        repeat.children.push_back(std::move(node));
+
+        node = std::move(repeat);
+    }
+
+    return true;
+}
+
+bool Regex::ParseAtom(const std::string & pattern, size_t & position, Node & node) {
+    char c = pattern[position];
+
+    node.type = NODE_TYPE::BYTES;
+
+    switch (c) {
+        case '(':
+            position++;
+
+            if (pattern.compare(position, 2, "?:") == 0) {
+                position += 2;
+            }
+
+            if (!ParseAlternation(pattern, position, node) || position >= pattern.size() || pattern[position] != ')') {
+                return false;
+            }
+
+            position++;
+            return true;
+        case '[':
+            return ParseClass(pattern, position, node.bytes);
+        case '\\':
+            return ParseEscape(pattern, position, node.bytes);
+        case '.':
+            node.bytes.set();
+            node.bytes.reset('\n');
+            break;
+        case '^':
+            node.type = NODE_TYPE::LINE_START;
+            break;
+        case '$':
+            node.type = NODE_TYPE::LINE_END;
+            break;
+        case '*':
+        case '+':
+        case '?':
+        case '{':
+            // A quantifier with nothing to repeat.
+            return false;
+        default:
+            node.bytes.set(static_cast<unsigned char>(c));
+            break;
+    }
+
+    position++;
+
+    return true;
+}
+
+bool Regex::ParseClass(const std::string & pattern, size_t & position, ByteSet & bytes) {
+    // Skip the '['.
+    position++;
+
+    bool negate = position < pattern.size() && pattern[position] == '^';
+
+    if (negate) {
+        position++;
+    }
+
+    bool first = true;
+
+    while (position < pattern.size() && (first || pattern[position] != ']')) {
+        first = false;
+
+        ByteSet item;
+
+        if (pattern[position] == '\\') {
+            if (!ParseEscape(pattern, position, item)) {
+                return false;
+            }
+        } else {
+            item.set(static_cast<unsigned char>(pattern[position++]));
+        }
+
+        // A range needs single bytes on both ends, a '-' at the end is literal.
+        if (item.count() == 1 && position + 1 < pattern.size() && pattern[position] == '-' && pattern[position + 1] != ']') {
+            position++;
+
+            ByteSet upper;
+
+            if (pattern[position] == '\\') {
+                if (!ParseEscape(pattern, position, upper) || upper.count() != 1) {
+                    return false;
+                }
+            } else {
+                upper.set(static_cast<unsigned char>(pattern[position++]));
+            }
+
+            int low = 0, high = 0;
+
+            while (!item.test(low)) {
+                low++;
+            }
+
+            while (!upper.test(high)) {
+                high++;
+            }
+
+            if (high < low) {
+                return false;
+            }
+
+            for (int byte = low; byte <= high; byte++) {
+                item.set(byte);
+            }
+        }
+
+        bytes |= item;
+    }
+
+    if (position >= pattern.size()) {
+        return false;
+    }
+
+    // Skip the ']'.
+    position++;
+
+    if (negate) {
+        bytes.flip();
+        bytes.reset('\n');
+    }
+
+    return true;
+}
+
+bool Regex::ParseEscape(const std::string & pattern, size_t & position, ByteSet & bytes) {
+    // Skip the '\'.
+    position++;
+
+    if (position >= pattern.size()) {
+        return false;
+    }
+
+    char c = pattern[position++];
+    ByteSet set;
+    bool negate = false;
+
+    switch (c) {
+        case 'D':
+            negate = true;
+            // Fall through.
+        case 'd':
+            for (int byte = '0'; byte <= '9'; byte++) {
+                set.set(byte);
+            }
+            break;
+        case 'W':
+            negate = true;
+            // Fall through.
+        case 'w':
+            for (int byte = 0; byte < 256; byte++) {
+                if (isalnum(byte) || byte == '_') {
+                    set.set(byte);
+                }
+            }
+            break;
+        case 'S':
+            negate = true;
+            // Fall through.
+        case 's':
+            for (const char *space = " \t\n\r\f\v"; *space != '\0'; space++) {
+                set.set(static_cast<unsigned char>(*space));
+            }
+            break;
+        case 'n':
+            set.set('\n');
+            break;
+        case 'r':
+            set.set('\r');
+            break;
+        case 't':
+            set.set('\t');
+            break;
+        case 'f':
+            set.set('\f');
+            break;
+        case 'v':
+            set.set('\v');
+            break;
+        default:
+            // Only punctuation is escaped to itself. Other letters and digits are word
+            // boundaries, backreferences and the like, which aren't supported.
+            if (isalnum(static_cast<unsigned char>(c))) {
+                return false;
+            }
+
+            set.set(static_cast<unsigned char>(c));
+            break;
+    }
+
+    if (negate) {
+        set.flip();
+    }
+
+    bytes |= set;
+
+    return true;
+}
+
+std::string Regex::Literal(const Node & node) {
+    switch (node.type) {
+        case NODE_TYPE::BYTES:
+            if (node.bytes.count() == 1) {
+                for (int byte = 0; byte < 256; byte++) {
+                    if (node.bytes.test(byte)) {
+                        return std::string(1, static_cast<char>(byte));
+                    }
+                }
+            }
+
+            return "";
+        case NODE_TYPE::REPEAT:
+            return node.min > 0 ? Literal(node.children[0]) : "";
+        case NODE_TYPE::ALTERNATE:
+            return node.children.size() == 1 ? Literal(node.children[0]) : "";
+        case NODE_TYPE::CONCAT: {
+            // Runs of single bytes are literals, anything else breaks the run but may
+            // contain a required literal of its own.
+            std::string best, run;
+
+            for (const Node & child : node.children) {
+                std::string part = Literal(child);
+
+                if (child.type == NODE_TYPE::BYTES && part.size() == 1) {
+                    run += part;
+                } else if (child.type != NODE_TYPE::LINE_START && child.type != NODE_TYPE::LINE_END) {
+                    best = Longer(best, run);
+                    best = Longer(best, part);
+                    run.clear();
+                }
+            }
+
+            return Longer(best, run);
+        }
+        default:
+            return "";
+    }
+}
+
+int Regex::AddState(NODE_TYPE type, int out, int alternative) {
+    State state;
+    state.type = type;
+    state.out = out;
+    state.alternative = alternative;
+
+    states.push_back(state);
+
+    return states.size() - 1;
+}
+
+void Regex::Patch(const Dangling & dangling, int target) {
+    for (const std::pair<int, int> & edge : dangling) {
+        if (edge.second == 0) {
+            states[edge.first].out = target;
+        } else {
+            states[edge.first].alternative = target;
+        }
+    }
+}
+
+int Regex::Compile(const Node & node, Dangling & dangling) {
+    switch (node.type) {
+        case NODE_TYPE::BYTES: {
+            int state = AddState(NODE_TYPE::BYTES);
+            states[state].bytes = node.bytes;
+            dangling.assign(1, std::make_pair(state, 0));
+
+            return state;
+        }
+        case NODE_TYPE::LINE_START:
+        case NODE_TYPE::LINE_END:
+        case NODE_TYPE::EMPTY: {
+            int state = AddState(node.type);
+            dangling.assign(1, std::make_pair(state, 0));
+
+            return state;
+        }
+        case NODE_TYPE::CONCAT: {
+            if (node.children.empty()) {
+                Node empty;
+                empty.type = NODE_TYPE::EMPTY;
+
+                return Compile(empty, dangling);
+            }
+
+            int first = Compile(node.children[0], dangling);
+
+            for (size_t i = 1; i < node.children.size(); i++) {
+                Dangling next;
+                int state = Compile(node.children[i], next);
+
+                Patch(dangling, state);
+                dangling.swap(next);
+            }
+
+            return first;
+        }
+        case NODE_TYPE::ALTERNATE: {
+            int first = Compile(node.children.back(), dangling);
+
+            for (size_t i = node.children.size() - 1; i-- > 0;) {
+                Dangling branch;
+                int state = Compile(node.children[i], branch);
+
+                first = AddState(NODE_TYPE::SPLIT, state, first);
+                dangling.insert(dangling.end(), branch.begin(), branch.end());
+            }
+
+            return first;
+        }
+        case NODE_TYPE::REPEAT: {
+            int first = -1;
+            dangling.clear();
+
+            auto append = [&](int state, Dangling & next) {
+                if (first < 0) {
+                    first = state;
+                } else {
+                    Patch(dangling, state);
+                }
+
+                dangling.swap(next);
+            };
+
+            for (int i = 0; i < node.min; i++) {
+                Dangling next;
+                int state = Compile(node.children[0], next);
+
+                append(state, next);
+            }
+
+            if (node.max < 0) {
+                // Loop back to a split that either repeats the child or moves on.
+                int split = AddState(NODE_TYPE::SPLIT);
+                Dangling body;
+                int state = Compile(node.children[0], body);
+
+                states[split].out = state;
+                Patch(body, split);
+
+                Dangling next(1, std::make_pair(split, 1));
+                append(split, next);
+            } else {
+                for (int i = node.min; i < node.max; i++) {
+                    int split = AddState(NODE_TYPE::SPLIT);
+                    Dangling next;
+                    int state = Compile(node.children[0], next);
+
+                    states[split].out = state;
+                    next.push_back(std::make_pair(split, 1));
+                    append(split, next);
+                }
+            }
+
+            if (first < 0) {
+                Node empty;
+                empty.type = NODE_TYPE::EMPTY;
+
+                return Compile(empty, dangling);
+            }
+
+            return first;
+        }
+        default:
+            return -1;
+    }
+}
+
+void Regex::Closure(std::vector<int> & set, bool line_start, bool line_end) {
+    if (++generation == 0) {
+        std::fill(visited.begin(), visited.end(), 0);
+        generation = 1;
+    }
+
+    std::vector<int> stack;
+    stack.swap(set);
+
+    while (!stack.empty()) {
+        int state = stack.back();
+        stack.pop_back();
+
+        if (state < 0 || visited[state] == generation) {
+            continue;
+        }
+
+        visited[state] = generation;
+
+        const State & current = states[state];
+
+        switch (current.type) {
+            case NODE_TYPE::SPLIT:
+                stack.push_back(current.out);
+                stack.push_back(current.alternative);
+                break;
+            case NODE_TYPE::EMPTY:
+                stack.push_back(current.out);
+                break;
+            case NODE_TYPE::LINE_START:
+                // Assertions stay in the set, so they can be followed later on.
+                set.push_back(state);
+
+                if (line_start) {
+                    stack.push_back(current.out);
+                }
+                break;
+            case NODE_TYPE::LINE_END:
+                set.push_back(state);
+
+                if (line_end) {
+                    stack.push_back(current.out);
+                }
+                break;
+            default:
+                set.push_back(state);
+                break;
+        }
+    }
+
+    std::sort(set.begin(), set.end());
+}
+
+int32_t Regex::Intern(std::vector<int> & set, bool initial) {
+    auto key = std::make_pair(initial, set);
+    auto existing = dfa_index.find(key);
+
+    if (existing != dfa_index.end()) {
+        return existing->second;
+    }
+
+    DfaState state;
+    state.states = set;
+    state.matched = false;
+
+    for (int nfa_state : set) {
+        if (states[nfa_state].type == NODE_TYPE::MATCH) {
+            state.matched = true;
+        }
+    }
+
+    // Whether reaching the end of the line here completes a match, satisfying any '$'.
+    std::vector<int> at_end = set;
+    Closure(at_end, initial, true);
+
+    state.matches_at_end = false;
+
+    for (int nfa_state : at_end) {
+        if (states[nfa_state].type == NODE_TYPE::MATCH) {
+            state.matches_at_end = true;
+        }
+    }
+
+    int32_t index = dfa.size();
+
+    dfa.push_back(std::move(state));
+    dfa_transitions.resize(dfa.size() * 256, -1);
+    dfa_index.insert(std::make_pair(std::move(key), index));
+
+    return index;
+}
+
+int32_t Regex::Step(int32_t from, unsigned char byte) {
+    std::vector<int> next;
+
+    for (int nfa_state : dfa[from].states) {
+        const State & current = states[nfa_state];
+
+        if (current.type == NODE_TYPE::BYTES && current.bytes.test(byte)) {
+            next.push_back(current.out);
+        }
+    }
+
+    // The expression is unanchored, so a match may start at every position.
+    next.push_back(start);
+    Closure(next, false, false);
+
+    if (dfa.size() >= MAX_DFA_STATES) {
+        ResetDfa();
+
+        return Intern(next, false);
+    }
+
+    int32_t to = Intern(next, false);
+    dfa_transitions[from * 256 + byte] = to;
+
+    return to;
+}
+
+void Regex::ResetDfa() {
+    dfa.clear();
+    dfa_transitions.clear();
+    dfa_index.clear();
+
+    visited.assign(states.size(), 0);
+    generation = 0;
+
+    if (!valid) {
+        return;
+    }
+
+    // The initial state is always state 0.
+    std::vector<int> initial(1, start);
+    Closure(initial, true, false);
+    Intern(initial, true);
+}
+
+bool Regex::Match(const char * data, size_t size) {
+    if (!valid) {
+        return false;
+    }
+
+    int32_t state = 0;
+
+    if (dfa[state].matched) {
+        return true;
+    }
+
+    const unsigned char *cursor = reinterpret_cast<const unsigned char *>(data);
+    const unsigned char *end = cursor + size;
+
+    for (; cursor < end; cursor++) {
+        int32_t next = dfa_transitions[state * 256 + *cursor];
+
+        state = next >= 0 ? next : Step(state, *cursor);
+
+        if (dfa[state].matched) {
+            return true;
+        }
+    }
+
+    return dfa[state].matches_at_end;
+}
+
+bool Regex::Match(const View & line) {
+    return Match(line.data(), line.size());
+}
+
+Reader::READ_STATUS Regex::SearchLines(Reader & reader, std::function<void(off_t, const View &)> callback) {
+    if (!valid) {
+        return Reader::READ_STATUS::ERROR;
+    }
+
+    LineSplitter splitter;
+
+    auto search_block = [&](off_t offset, const View & block) {
+        const char *begin = block.begin();
+        const char *end = block.end();
+
+        if (literal.empty()) {
+            const char *line_start = begin;
+
+            while (line_start < end) {
+                const char *line_end = static_cast<const char *>(memchr(line_start, '\n', end - line_start));
+                line_end = line_end == nullptr ? end : line_end;
+
+                if (Match(line_start, line_end - line_start)) {
+                    callback(offset + (line_start - begin), View(line_start, line_end - line_start));
+                }
+
+                line_start = line_end + 1;
+            }
+
+            return;
+        }
+
+        // Only lines containing the required literal can match.
+        size_t position = 0;
+
+        while ((position = literal_searcher.Find(block, position)) != View::npos) {
+            const char *match = begin + position;
+            const char *line_start = static_cast<const char *>(memrchr(begin, '\n', match - begin));
+            const char *line_end = static_cast<const char *>(memchr(match, '\n', end - match));
+
+            line_start = line_start == nullptr ? begin : line_start + 1;
+            line_end = line_end == nullptr ? end : line_end;
+
+            if (Match(line_start, line_end - line_start)) {
+                callback(offset + (line_start - begin), View(line_start, line_end - line_start));
+            }
+
+            position = line_end - begin + 1;
+        }
+    };
+
+    Reader::READ_STATUS status = reader.Read([&](std::string & chunk) {
+        splitter.FeedBlocks(chunk.data(), chunk.size(), search_block);
+    });
+
+    if (!reader.StatusError(status)) {
+        splitter.FinishBlocks(search_block);
+    }
+
+    return status;
+}
+
+} // End File
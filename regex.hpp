@@ -0,0 +1,132 @@
+#ifndef FILE_REGEX_H
+#define FILE_REGEX_H
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <bitset>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <functional>
+
+#include "file.hpp"
+#include "search.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+// A regular expression for filtering lines, matched with a lazily built DFA.
+//
+// Supported syntax: literals, '.', classes ([a-z], [^0-9]), the \d \w \s \D \W \S shorthands,
+// the \n \r \t \f \v escapes and escaped punctuation, grouping with (...) and (?:...),
+// alternation, the *, +, ? and {n,m} quantifiers, and the ^ and $ anchors, which match at
+// the start and end of a line.
+//
+// Before running the DFA, SearchLines looks for a literal that every match has to contain
+// with the vectorized Searcher, so only candidate lines are ever handed to the DFA.
+//
+// The DFA is built while matching, so a Regex must not be shared between threads.
+class Regex
+{
+public:
+  explicit Regex(const std::string &pattern);
+
+  // False when the pattern couldn't be parsed, nothing will match.
+  bool Valid() const;
+
+  // Whether the line contains a match.
+  bool Match(const char *data, size_t size);
+  bool Match(const View &line);
+
+  // A literal contained in every match, empty if there isn't one.
+  const std::string &RequiredLiteral() const;
+
+  // Report every line matching the expression, along with the line's file offset.
+  Reader::READ_STATUS SearchLines(Reader &reader, std::function<void(off_t, const View &)> callback);
+
+private:
+  enum class NODE_TYPE : char
+  {
+    BYTES,
+    EMPTY,
+    LINE_START,
+    LINE_END,
+    CONCAT,
+    ALTERNATE,
+    REPEAT,
+    MATCH,
+    SPLIT
+  };
+
+  typedef std::bitset<256> ByteSet;
+
+  // Parsed expression.
+  struct Node
+  {
+    NODE_TYPE type;
+    ByteSet bytes;
+    std::vector<Node> children;
+    int min;
+    int max;
+  };
+
+  // A state of the Thompson NFA the expression is compiled to.
+  struct State
+  {
+    NODE_TYPE type;
+    ByteSet bytes;
+    int out;
+    int alternative;
+  };
+
+  // A DFA state, which is a set of NFA states.
+  struct DfaState
+  {
+    std::vector<int> states;
+    bool matched;
+    bool matches_at_end;
+  };
+
+  typedef std::vector<std::pair<int, int>> Dangling;
+
+  bool valid;
+  std::string literal;
+  Searcher literal_searcher;
+
+  std::vector<State> states;
+  int start;
+
+  std::vector<DfaState> dfa;
+  std::vector<int32_t> dfa_transitions;
+  std::map<std::pair<bool, std::vector<int>>, int32_t> dfa_index;
+
+  std::vector<unsigned> visited;
+  unsigned generation;
+
+  // Parsing.
+  bool ParseAlternation(const std::string &pattern, size_t &position, Node &node);
+  bool ParseConcatenation(const std::string &pattern, size_t &position, Node &node);
+  bool ParseRepetition(const std::string &pattern, size_t &position, Node &node);
+  bool ParseAtom(const std::string &pattern, size_t &position, Node &node);
+  bool ParseClass(const std::string &pattern, size_t &position, ByteSet &bytes);
+  bool ParseEscape(const std::string &pattern, size_t &position, ByteSet &bytes);
+
+  static std::string Literal(const Node &node);
+
+  // NFA construction.
+  int AddState(NODE_TYPE type, int out = -1, int alternative = -1);
+  void Patch(const Dangling &dangling, int target);
+  int Compile(const Node &node, Dangling &dangling);
+
+  // DFA construction.
+  void Closure(std::vector<int> &set, bool line_start, bool line_end);
+  int32_t Intern(std::vector<int> &set, bool initial);
+  int32_t Step(int32_t from, unsigned char byte);
+  void ResetDfa();
+};
+
+} // End File
+
+#endif // FILE_REGEX_H
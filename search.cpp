@@ -0,0 +1,233 @@
+#include "search.hpp"
+#include "lines.hpp"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILE_SEARCH_X86 1
+#endif
+
+namespace File {
+
+namespace {
+
+typedef size_t (*FindFunction)(const char *, size_t, const char *, size_t);
+
+// Every find function expects a pattern of at least 2 bytes and a haystack at least as long.
+size_t FindScalar(const char * data, size_t size, const char * pattern, size_t length) {
+    const char *cursor = data;
+    const char *last_start = data + size - length;
+
+    while (cursor <= last_start) {
+        cursor = static_cast<const char *>(memchr(cursor, pattern[0], last_start - cursor + 1));
+
+        if (cursor == nullptr) {
+            break;
+        }
+
+        if (cursor[length - 1] == pattern[length - 1] && memcmp(cursor + 1, pattern + 1, length - 2) == 0) {
+            return cursor - data;
+        }
+
+        cursor++;
+    }
+
+    return View::npos;
+}
+
+#ifdef FILE_SEARCH_X86
+
+__attribute__((target("sse2")))
+size_t FindSse2(const char * data, size_t size, const char * pattern, size_t length) {
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[length - 1]);
+
+    size_t i = 0;
+
+    for (; i + length - 1 + 16 <= size; i += 16) {
+        const __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + length - 1));
+
+        unsigned mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+
+        while (mask != 0) {
+            unsigned bit = __builtin_ctz(mask);
+
+            if (memcmp(data + i + bit + 1, pattern + 1, length - 2) == 0) {
+                return i + bit;
+            }
+
+            mask &= mask - 1;
+        }
+    }
+
+    size_t position = FindScalar(data + i, size - i, pattern, length);
+
+    return position == View::npos ? View::npos : i + position;
+}
+
+__attribute__((target("avx2")))
+size_t FindAvx2(const char * data, size_t size, const char * pattern, size_t length) {
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[length - 1]);
+
+    size_t i = 0;
+
+    for (; i + length - 1 + 32 <= size; i += 32) {
+        const __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + length - 1));
+
+        unsigned mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last)));
+
+        while (mask != 0) {
+            unsigned bit = __builtin_ctz(mask);
+
+            if (memcmp(data + i + bit + 1, pattern + 1, length - 2) == 0) {
+                return i + bit;
+            }
+
+            mask &= mask - 1;
+        }
+    }
+
+    size_t position = FindSse2(data + i, size - i, pattern, length);
+
+    return position == View::npos ? View::npos : i + position;
+}
+
+#endif
+
+FindFunction SelectFind() {
+#ifdef FILE_SEARCH_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return FindAvx2;
+    }
+
+    if (__builtin_cpu_supports("sse2")) {
+        return FindSse2;
+    }
+#endif
+
+    return FindScalar;
+}
+
+} // End anonymous namespace
+
+Searcher::Searcher(const std::string & pattern) :
+    pattern(pattern)
+{}
+
+const std::string & Searcher::Pattern() const {
+    return pattern;
+}
+
+size_t Searcher::Find(const char * data, size_t size, size_t from) const {
+    static const FindFunction find = SelectFind();
+
+    const size_t length = pattern.size();
+
+    // An empty pattern never matches.
+    if (length == 0 || from >= size || size - from < length) {
+        return View::npos;
+    }
+
+    if (length == 1) {
+        const void *match = memchr(data + from, pattern[0], size - from);
+
+        if (match == nullptr) {
+            return View::npos;
+        }
+
+        return static_cast<const char *>(match) - data;
+    }
+
+    size_t position = find(data + from, size - from, pattern.data(), length);
+
+    return position == View::npos ? View::npos : from + position;
+}
+
+size_t Searcher::Find(const View & haystack, size_t from) const {
+    return Find(haystack.data(), haystack.size(), from);
+}
+
+Reader::READ_STATUS Searcher::Search(Reader & reader, std::function<void(off_t)> callback) const {
+    const size_t overlap = pattern.empty() ? 0 : pattern.size() - 1;
+
+    // The last pattern.size() - 1 bytes of the stream, where a straddling match may start.
+    std::string tail, boundary;
+    off_t offset = 0;
+
+    return reader.Read([&](std::string & chunk) {
+        if (!tail.empty()) {
+            boundary.assign(tail);
+            boundary.append(chunk, 0, overlap);
+
+            size_t position = 0;
+
+            while ((position = Find(boundary.data(), boundary.size(), position)) < tail.size()) {
+                callback(offset - tail.size() + position);
+                position++;
+            }
+        }
+
+        size_t position = 0;
+
+        while ((position = Find(chunk.data(), chunk.size(), position)) != View::npos) {
+            callback(offset + position);
+            position++;
+        }
+
+        if (chunk.size() >= overlap) {
+            tail.assign(chunk, chunk.size() - overlap, overlap);
+        } else {
+            tail.append(chunk);
+
+            if (tail.size() > overlap) {
+                tail.erase(0, tail.size() - overlap);
+            }
+        }
+
+        offset += chunk.size();
+    });
+}
+
+Reader::READ_STATUS Searcher::SearchLines(Reader & reader, std::function<void(off_t, const View &)> callback) const {
+    LineSplitter splitter;
+
+    // Search a whole block of lines at once, only looking for line boundaries around matches.
+    auto search_block = [&](off_t offset, const View & block) {
+        const char *begin = block.begin();
+        const char *end = block.end();
+        size_t position = 0;
+
+        while ((position = Find(block, position)) != View::npos) {
+            const char *match = begin + position;
+            const char *line_start = static_cast<const char *>(memrchr(begin, '\n', match - begin));
+            const char *line_end = static_cast<const char *>(memchr(match, '\n', end - match));
+
+            line_start = line_start == nullptr ? begin : line_start + 1;
+            line_end = line_end == nullptr ? end : line_end;
+
+            callback(offset + (line_start - begin), View(line_start, line_end - line_start));
+
+            position = line_end - begin + 1;
+        }
+    };
+
+    Reader::READ_STATUS status = reader.Read([&](std::string & chunk) {
+        splitter.FeedBlocks(chunk.data(), chunk.size(), search_block);
+    });
+
+    if (!reader.StatusError(status)) {
+        splitter.FinishBlocks(search_block);
+    }
+
+    return status;
+}
+
+} // End File
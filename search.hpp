@@ -0,0 +1,40 @@
+#ifndef FILE_SEARCH_H
+#define FILE_SEARCH_H
+
+#include <sys/types.h>
+#include <string>
+#include <functional>
+
+#include "file.hpp"
+#include "view.hpp"
+
+namespace File
+{
+
+// Substring search using a vectorized first/last byte filter. AVX2 is used when the CPU
+// supports it, falling back to SSE2 and then to a memchr based scalar loop.
+class Searcher
+{
+public:
+  explicit Searcher(const std::string &pattern);
+
+  // Position of the first occurrence at or after from, View::npos if there is none.
+  size_t Find(const char *data, size_t size, size_t from = 0) const;
+  size_t Find(const View &haystack, size_t from = 0) const;
+
+  // Report the file offset of every occurrence in the reader's stream, including
+  // occurrences straddling two chunks.
+  Reader::READ_STATUS Search(Reader &reader, std::function<void(off_t)> callback) const;
+
+  // Report every line containing the pattern, along with the line's file offset.
+  Reader::READ_STATUS SearchLines(Reader &reader, std::function<void(off_t, const View &)> callback) const;
+
+  const std::string &Pattern() const;
+
+private:
+  std::string pattern;
+};
+
+} // End File
+
+#endif // FILE_SEARCH_H
@@ -0,0 +1,64 @@
+#include "test_header.h"
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../affinity.hpp"
+#include "../thread_pool.hpp"
+
+TEST_CASE("Affinity", "[affinity]") {
+    std::vector<int> cpus = File::AllowedCpus();
+
+    REQUIRE(!cpus.empty());
+    REQUIRE(std::is_sorted(cpus.begin(), cpus.end()));
+
+    SECTION("CPUs grouped by node are the allowed CPUs") {
+        std::vector<int> by_node = File::CpusByNode();
+
+        REQUIRE(by_node.size() == cpus.size());
+
+        for (size_t i = 1; i < by_node.size(); i++) {
+            REQUIRE(File::CpuNode(by_node[i - 1]) <= File::CpuNode(by_node[i]));
+        }
+
+        std::sort(by_node.begin(), by_node.end());
+        REQUIRE(by_node == cpus);
+    }
+
+    SECTION("A thread can be pinned") {
+        int cpu = cpus.back();
+        bool pinned = false;
+        int running_on = -1;
+
+        // Pin a thread of our own, the test runner's thread is left alone.
+        std::thread thread([&]() {
+            pinned = File::PinCurrentThread(cpu);
+            running_on = sched_getcpu();
+        });
+
+        thread.join();
+
+        REQUIRE(pinned);
+        REQUIRE(running_on == cpu);
+    }
+
+    SECTION("Pinned workers run on their node") {
+        File::ThreadPool pool(2, true);
+        std::atomic<int> wrong_node(0);
+
+        for (int i = 0; i < 100; i++) {
+            pool.Submit([&pool, &wrong_node]() {
+                if (File::CpuNode(sched_getcpu()) != pool.WorkerNode()) {
+                    wrong_node++;
+                }
+            });
+        }
+
+        pool.Wait();
+
+        REQUIRE(wrong_node == 0);
+        REQUIRE(pool.WorkerNode() == -1);
+    }
+}
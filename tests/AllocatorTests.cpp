@@ -0,0 +1,191 @@
+#include "test_header.h"
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../allocator.hpp"
+#include "../file.hpp"
+#include "../pipeline.hpp"
+#include "../thread_pool.hpp"
+
+TEST_CASE("Allocator", "[allocator]") {
+    using File::Arena;
+    using File::BufferAllocator;
+    using File::Reader;
+    using File::View;
+
+    SECTION("The pool rounds up to size classes and reuses freed buffers") {
+        const BufferAllocator &pooled = BufferAllocator::Pooled();
+        size_t capacity = 0;
+
+        char *first = pooled.Allocate(5000, &capacity);
+        REQUIRE(first != nullptr);
+        REQUIRE(capacity == 8192);
+        REQUIRE(reinterpret_cast<uintptr_t>(first) % 64 == 0);
+
+        pooled.Free(first, capacity);
+
+        size_t again = 0;
+        REQUIRE(pooled.Allocate(6000, &again) == first);
+        REQUIRE(again == 8192);
+        pooled.Free(first, again);
+
+        // Too big for any class.
+        char *large = pooled.Allocate((64 << 20) + 1, &capacity);
+        REQUIRE(large != nullptr);
+        REQUIRE(capacity == (64 << 20) + 1);
+        pooled.Free(large, capacity);
+    }
+
+    SECTION("Each thread has its own pool") {
+        const BufferAllocator &pooled = BufferAllocator::Pooled();
+        size_t capacity = 0;
+
+        char *mine = pooled.Allocate(4096, &capacity);
+        pooled.Free(mine, capacity);
+
+        char *theirs = nullptr;
+
+        std::thread thread([&]() {
+            size_t their_capacity = 0;
+            theirs = pooled.Allocate(4096, &their_capacity);
+            pooled.Free(theirs, their_capacity);
+        });
+
+        thread.join();
+
+        REQUIRE(theirs != mine);
+
+        // Still in this thread's pool.
+        REQUIRE(pooled.Allocate(4096, &capacity) == mine);
+        pooled.Free(mine, capacity);
+    }
+
+    SECTION("Cached buffers can be trimmed, and idle pool workers trim theirs") {
+        const BufferAllocator &pooled = BufferAllocator::Pooled();
+        size_t capacity = 0;
+
+        BufferAllocator::Trim();
+
+        char *memory = pooled.Allocate(1 << 16, &capacity);
+        pooled.Free(memory, capacity);
+        REQUIRE(BufferAllocator::CachedBytes() == capacity);
+
+        BufferAllocator::Trim();
+        REQUIRE(BufferAllocator::CachedBytes() == 0);
+
+        File::ThreadPool pool(1);
+        size_t cached_after_task = 0;
+        size_t cached_after_idle = 0;
+
+        pool.Submit([&]() {
+            size_t worker_capacity = 0;
+            char *worker_memory = pooled.Allocate(1 << 16, &worker_capacity);
+            pooled.Free(worker_memory, worker_capacity);
+            cached_after_task = BufferAllocator::CachedBytes();
+        });
+
+        pool.Wait();
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        pool.Submit([&]() {
+            cached_after_idle = BufferAllocator::CachedBytes();
+        });
+
+        pool.Wait();
+
+        REQUIRE(cached_after_task == 1 << 16);
+        REQUIRE(cached_after_idle == 0);
+    }
+
+    SECTION("Readers can use a custom allocator") {
+        size_t allocations = 0;
+
+        BufferAllocator counting([&allocations](size_t size, size_t * capacity) {
+            allocations++;
+            return BufferAllocator::Heap().Allocate(size, capacity);
+        }, [](char * memory, size_t capacity) {
+            BufferAllocator::Heap().Free(memory, capacity);
+        });
+
+        {
+            Reader reader;
+            REQUIRE(File::StatusOk(reader.Open("../data/file")));
+            reader.SetAllocator(counting).SetReadSize(100);
+
+            std::string contents;
+            reader.Read([&contents](std::string & chunk) { contents += chunk; });
+
+            REQUIRE(contents.size() == 6412);
+        }
+
+        // One buffer for the whole read.
+        REQUIRE(allocations == 1);
+    }
+
+    SECTION("An arena hands out aligned memory and keeps its blocks across resets") {
+        Arena arena(1024);
+
+        char *first = arena.Allocate(10);
+        char *second = arena.Allocate(16, 16);
+
+        REQUIRE(first != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(second) % 16 == 0);
+        REQUIRE(second >= first + 10);
+
+        // Bigger than a block.
+        REQUIRE(arena.Allocate(5000) != nullptr);
+
+        View copy = arena.Copy(View("hello", 5));
+        REQUIRE(copy == View("hello", 5));
+
+        size_t capacity = arena.Capacity();
+
+        for (int round = 0; round < 10; round++) {
+            arena.Reset();
+            REQUIRE(arena.Used() == 0);
+
+            REQUIRE(arena.Allocate(10) == first);
+            arena.Allocate(5000);
+            arena.Copy(View("hello", 5));
+        }
+
+        REQUIRE(arena.Capacity() == capacity);
+    }
+
+    SECTION("Pipeline stages can allocate into the chunk arena") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        reader.SetReadSize(64);
+
+        std::vector<std::string> upper;
+
+        File::From(reader)
+            | File::Split('\n')
+            | File::Map([](const View & line) {
+                char *copy = File::ChunkArena().Allocate(line.size(), 1);
+
+                for (size_t i = 0; i < line.size(); i++) {
+                    copy[i] = toupper(line[i]);
+                }
+
+                return View(copy, line.size());
+            })
+            | File::ForEach([&upper](const View & line) { upper.push_back(line.str()); });
+
+        REQUIRE(upper.size() == 19);
+        REQUIRE(File::ChunkArena().Used() == 0);
+
+        bool all_upper = true;
+
+        for (const std::string & line : upper) {
+            for (char c : line) {
+                all_upper = all_upper && c == toupper(c);
+            }
+        }
+
+        REQUIRE(all_upper);
+    }
+}
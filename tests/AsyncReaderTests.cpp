@@ -0,0 +1,205 @@
+#include "test_header.h"
+
+// Built as C++20 when the compiler supports it, see CMakeLists.txt.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../file.hpp"
+#include "../async_reader.hpp"
+#include "../memory_budget.hpp"
+
+namespace {
+
+// A fire and forget coroutine, standing in for an event loop's task type.
+struct Task
+{
+  struct promise_type
+  {
+    Task get_return_object() { return Task(); }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+struct Latch
+{
+  std::mutex lock;
+  std::condition_variable done;
+  size_t remaining;
+
+  void CountDown()
+  {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (--remaining == 0) {
+      done.notify_all();
+    }
+  }
+
+  void Wait()
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this]() { return remaining == 0; });
+  }
+};
+
+Task ReadChunks(File::AsyncReader & async, std::string & output, std::thread::id & resumed_on, Latch & latch)
+{
+  std::string buffer;
+  File::Reader::READ_STATUS status;
+
+  do {
+    status = co_await async.ReadAsync(buffer);
+    output += buffer;
+  } while (File::Reader().StatusOk(status) && !File::Reader().StatusEndOfFile(status));
+
+  resumed_on = std::this_thread::get_id();
+  latch.CountDown();
+}
+
+Task StreamChunks(File::AsyncReader & async, std::string & output, bool & end_of_file, Latch & latch)
+{
+  auto chunks = async.Chunks();
+
+  while (co_await chunks.Next()) {
+    output += chunks.Current();
+  }
+
+  end_of_file = File::Reader().StatusEndOfFile(chunks.Status());
+  latch.CountDown();
+}
+
+} // End anonymous namespace
+
+TEST_CASE("AsyncReader", "[async]") {
+    using File::Reader;
+
+    const size_t scans = 16;
+
+    // Reads lock the file, so give every scan a file of its own.
+    std::vector<std::string> paths;
+    std::vector<std::string> expected(scans);
+
+    for (size_t i = 0; i < scans; i++) {
+        char path[] = "/tmp/file-reader-async-XXXXXX";
+        int descriptor = mkstemp(path);
+        REQUIRE(descriptor != -1);
+
+        for (size_t j = 0; j < 1000 + i * 37; j++) {
+            expected[i] += static_cast<char>('a' + (i + j) % 26);
+        }
+
+        REQUIRE(write(descriptor, expected[i].data(), expected[i].size()) == static_cast<ssize_t>(expected[i].size()));
+        close(descriptor);
+
+        paths.push_back(path);
+    }
+
+    std::vector<Reader> readers(scans);
+    std::vector<File::AsyncReader> asyncs;
+    std::vector<std::string> outputs(scans);
+
+    for (size_t i = 0; i < scans; i++) {
+        REQUIRE(File::StatusOk(readers[i].Open(paths[i])));
+        readers[i].SetReadSize(100);
+        asyncs.emplace_back(readers[i]);
+    }
+
+    Latch latch;
+    latch.remaining = scans;
+
+    // Cached chunks complete without suspending, so a scan may finish on this thread.
+    SECTION("One thread drives many reads") {
+        std::vector<std::thread::id> resumed_on(scans);
+
+        for (size_t i = 0; i < scans; i++) {
+            ReadChunks(asyncs[i], outputs[i], resumed_on[i], latch);
+        }
+
+        latch.Wait();
+
+        for (size_t i = 0; i < scans; i++) {
+            REQUIRE(outputs[i] == expected[i]);
+        }
+    }
+
+    SECTION("Reads that would block are offloaded to the pool") {
+        std::vector<std::thread::id> resumed_on(scans);
+
+        // Every read would block, whatever the page cache holds.
+        for (size_t i = 0; i < scans; i++) {
+            readers[i].SetNonBlockingReads(false);
+        }
+
+        for (size_t i = 0; i < scans; i++) {
+            ReadChunks(asyncs[i], outputs[i], resumed_on[i], latch);
+        }
+
+        latch.Wait();
+
+        for (size_t i = 0; i < scans; i++) {
+            REQUIRE(outputs[i] == expected[i]);
+
+            // The reads went to the pool, so the scan went on from a pool thread.
+            REQUIRE(resumed_on[i] != std::this_thread::get_id());
+        }
+    }
+
+    SECTION("A shared budget bounds the chunks in flight") {
+        // Room for two chunks at a time across all the scans.
+        File::MemoryBudget budget(200);
+        std::vector<File::AsyncReader> budgeted;
+        std::vector<std::thread::id> resumed_on(scans);
+
+        for (size_t i = 0; i < scans; i++) {
+            budgeted.emplace_back(readers[i], File::IoPool(), &budget);
+        }
+
+        for (size_t i = 0; i < scans; i++) {
+            ReadChunks(budgeted[i], outputs[i], resumed_on[i], latch);
+        }
+
+        latch.Wait();
+
+        for (size_t i = 0; i < scans; i++) {
+            REQUIRE(outputs[i] == expected[i]);
+        }
+
+        REQUIRE(budget.InUse() == 0);
+        REQUIRE(budget.Peak() > 0);
+        REQUIRE(budget.Peak() <= 200);
+    }
+
+    SECTION("Chunks can be streamed") {
+        std::unique_ptr<bool[]> end_of_file(new bool[scans]());
+
+        for (size_t i = 0; i < scans; i++) {
+            StreamChunks(asyncs[i], outputs[i], end_of_file[i], latch);
+        }
+
+        latch.Wait();
+
+        for (size_t i = 0; i < scans; i++) {
+            REQUIRE(outputs[i] == expected[i]);
+            REQUIRE(end_of_file[i]);
+        }
+    }
+
+    for (const std::string & path : paths) {
+        unlink(path.c_str());
+    }
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include "test_header.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "../file.hpp"
+#include "../batch_reader.hpp"
+
+TEST_CASE("BatchReader", "[batch]") {
+    using File::BatchReader;
+    using File::Reader;
+
+    char directory[] = "/tmp/file-reader-batch-XXXXXX";
+    REQUIRE(mkdtemp(directory) != nullptr);
+
+    std::string nested = std::string(directory) + "/nested";
+    REQUIRE(mkdir(nested.c_str(), 0700) == 0);
+
+    std::map<std::string, std::string> expected;
+
+    for (int i = 0; i < 40; i++) {
+        std::string path = (i % 4 == 0 ? nested : std::string(directory)) + "/file-" + std::to_string(i);
+        std::string contents;
+
+        for (int j = 0; j < i * 7; j++) {
+            contents += static_cast<char>('a' + (i + j) % 26);
+        }
+
+        FILE *file = fopen(path.c_str(), "w");
+        REQUIRE(file != nullptr);
+        fwrite(contents.data(), 1, contents.size(), file);
+        fclose(file);
+
+        expected[path] = contents;
+    }
+
+    SECTION("It lists a directory, optionally recursively") {
+        REQUIRE(BatchReader::ListDirectory(directory, false).size() == 30);
+        REQUIRE(BatchReader::ListDirectory(directory, true).size() == 40);
+    }
+
+    SECTION("It reads every file concurrently, keeping each file's chunks in order") {
+        std::vector<std::string> paths = BatchReader::ListDirectory(directory, true);
+        paths.push_back(std::string(directory) + "/missing");
+
+        std::vector<std::string> actual(paths.size());
+        std::vector<int> done(paths.size(), 0);
+        size_t failures = 0;
+
+        BatchReader batch(4);
+        batch.SetReadSize(10).SetMaxBufferedBytes(64);
+
+        Reader::READ_STATUS status = batch.Read(paths,
+            [&actual](size_t file, std::string & chunk) {
+                actual[file] += chunk;
+            },
+            [&done, &failures](size_t file, Reader::READ_STATUS file_status) {
+                done[file]++;
+
+                if ((file_status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR) {
+                    failures++;
+                }
+            });
+
+        // The missing file fails the batch as a whole.
+        REQUIRE((status & Reader::READ_STATUS::ERROR) == Reader::READ_STATUS::ERROR);
+        REQUIRE(failures == 1);
+        REQUIRE(std::count(done.begin(), done.end(), 1) == (long) paths.size());
+
+        for (size_t file = 0; file + 1 < paths.size(); file++) {
+            REQUIRE(actual[file] == expected[paths[file]]);
+        }
+    }
+
+    for (auto & entry : expected) {
+        unlink(entry.first.c_str());
+    }
+
+    rmdir(nested.c_str());
+    rmdir(directory);
+}
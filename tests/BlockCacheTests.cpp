@@ -0,0 +1,165 @@
+#include "test_header.h"
+#include <string>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../file.hpp"
+#include "../block_cache.hpp"
+
+TEST_CASE("BlockCache", "[cache]") {
+    using File::BlockCache;
+    using File::Reader;
+
+    std::string expected;
+    {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        REQUIRE(reader.StatusOk(reader.ReadAll(expected)));
+    }
+
+    SECTION("It reads the same bytes through the cache") {
+        BlockCache cache(1 << 20, 1000);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        reader.SetBlockCache(&cache).SetReadSize(333);
+
+        std::string actual;
+        Reader::READ_STATUS status = reader.Read([&actual](std::string & chunk) {
+            actual += chunk;
+        });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected);
+        REQUIRE(cache.Misses() == 7);
+        REQUIRE(cache.Size() == expected.size());
+    }
+
+    SECTION("A second reader of the same file is served from the cache") {
+        BlockCache cache(1 << 20, 1000);
+
+        for (int i = 0; i < 2; i++) {
+            Reader reader;
+            REQUIRE(File::StatusOk(reader.Open("../data/file")));
+            reader.SetBlockCache(&cache);
+
+            std::string actual;
+            REQUIRE(reader.StatusOk(reader.ReadAll(actual)));
+            REQUIRE(actual == expected);
+        }
+
+        REQUIRE(cache.Misses() == 7);
+        REQUIRE(cache.Hits() == 7);
+    }
+
+    SECTION("It evicts to stay within capacity") {
+        BlockCache cache(2000, 1000, 1);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        reader.SetBlockCache(&cache);
+
+        std::string actual;
+        REQUIRE(reader.StatusOk(reader.ReadAll(actual)));
+        REQUIRE(actual == expected);
+        REQUIRE(cache.Size() <= 2000);
+
+        cache.Clear();
+        REQUIRE(cache.Size() == 0);
+    }
+
+    SECTION("Blocks of a modified file are not served") {
+        char path[] = "/tmp/file-reader-cache-XXXXXX";
+        int descriptor = mkstemp(path);
+        REQUIRE(descriptor != -1);
+        REQUIRE(write(descriptor, "first", 5) == 5);
+
+        BlockCache cache(1 << 20, 1000);
+        std::string actual;
+
+        {
+            Reader reader;
+            REQUIRE(File::StatusOk(reader.Open(path)));
+            reader.SetBlockCache(&cache);
+            REQUIRE(reader.StatusOk(reader.ReadAll(actual)));
+            REQUIRE(actual == "first");
+        }
+
+        REQUIRE(pwrite(descriptor, "second", 6, 0) == 6);
+        close(descriptor);
+
+        // Make sure the mtime moves even on a coarse clock.
+        struct timespec times[2] = {{0, UTIME_OMIT}, {12345, 0}};
+        REQUIRE(utimensat(AT_FDCWD, path, times, 0) == 0);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+        reader.SetBlockCache(&cache);
+        REQUIRE(reader.StatusOk(reader.ReadAll(actual)));
+        REQUIRE(actual == "second");
+
+        unlink(path);
+    }
+
+    SECTION("A reader opened before the file changed doesn't serve stale blocks") {
+        char path[] = "/tmp/file-reader-cache-XXXXXX";
+        int descriptor = mkstemp(path);
+        REQUIRE(descriptor != -1);
+        REQUIRE(write(descriptor, "first", 5) == 5);
+
+        BlockCache cache(1 << 20, 1000);
+        std::string actual;
+
+        // Opened now, read only after the change.
+        Reader long_lived;
+        REQUIRE(File::StatusOk(long_lived.Open(path)));
+        long_lived.SetBlockCache(&cache);
+
+        {
+            Reader reader;
+            REQUIRE(File::StatusOk(reader.Open(path)));
+            reader.SetBlockCache(&cache);
+            REQUIRE(reader.StatusOk(reader.ReadAll(actual)));
+            REQUIRE(actual == "first");
+        }
+
+        // Same size, so only the mtime tells the versions apart.
+        REQUIRE(pwrite(descriptor, "final", 5, 0) == 5);
+        close(descriptor);
+
+        struct timespec times[2] = {{0, UTIME_OMIT}, {12345, 0}};
+        REQUIRE(utimensat(AT_FDCWD, path, times, 0) == 0);
+
+        REQUIRE(long_lived.StatusOk(long_lived.ReadAll(actual)));
+        REQUIRE(actual == "final");
+
+        // What it loaded is keyed on the new version, so other readers can use it.
+        size_t hits = cache.Hits();
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+        reader.SetBlockCache(&cache);
+        REQUIRE(reader.StatusOk(reader.ReadAll(actual)));
+        REQUIRE(actual == "final");
+        REQUIRE(cache.Hits() > hits);
+
+        unlink(path);
+    }
+
+    SECTION("Turning the cache off continues from the same offset") {
+        BlockCache cache(1 << 20, 1000);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        reader.SetBlockCache(&cache);
+
+        char buffer[100];
+        ssize_t bytes_read = 0;
+        REQUIRE(reader.StatusOk(reader.Read(buffer, sizeof(buffer), &bytes_read)));
+        REQUIRE(bytes_read == 100);
+
+        reader.SetBlockCache(nullptr);
+        REQUIRE(reader.StatusOk(reader.Read(buffer, sizeof(buffer), &bytes_read)));
+        REQUIRE(std::string(buffer, bytes_read) == expected.substr(100, 100));
+    }
+}
@@ -0,0 +1,110 @@
+#include "test_header.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <stdlib.h>
+
+#include "../file.hpp"
+#include "../csv.hpp"
+
+typedef std::vector<std::vector<std::string>> Rows;
+
+static std::string WriteTemporary(const std::string &contents) {
+    char path[] = "/tmp/file-reader-csv-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd != -1);
+    REQUIRE(write(fd, contents.data(), contents.size()) == (ssize_t) contents.size());
+    close(fd);
+
+    return path;
+}
+
+TEST_CASE("CsvParser", "[csv]") {
+    using File::CsvParser;
+    using File::Reader;
+
+    SECTION("It splits rows into fields, honouring quotes across chunk boundaries") {
+        // Build a table whose fields contain delimiters, newlines and escaped quotes.
+        std::mt19937 generator(7);
+        std::vector<std::string> samples = {"plain", "", "with,comma", "multi\nline", "say \"\"hi\"\"", "12.5"};
+        std::uniform_int_distribution<size_t> pick(0, samples.size() - 1);
+
+        Rows expected;
+        std::string contents;
+
+        for (int row = 0; row < 200; row++) {
+            std::vector<std::string> fields;
+
+            for (int column = 0; column < 5; column++) {
+                const std::string &sample = samples[pick(generator)];
+                bool quoted = sample.find_first_of(",\n\"") != std::string::npos || column == 2;
+
+                if (column > 0) {
+                    contents += ',';
+                }
+
+                contents += quoted ? "\"" + sample + "\"" : sample;
+                fields.push_back(quoted ? "\"" + sample + "\"" : sample);
+            }
+
+            contents += row % 3 == 0 ? "\r\n" : "\n";
+            expected.push_back(fields);
+        }
+
+        std::string path = WriteTemporary(contents);
+
+        for (size_t read_size = 7; read_size < 300; read_size += 71) {
+            Reader reader;
+            REQUIRE(File::StatusOk(reader.Open(path)));
+            reader.SetReadSize(read_size);
+
+            CsvParser parser;
+            Rows actual;
+
+            Reader::READ_STATUS status = parser.Parse(reader, [&actual](const std::vector<File::View> & fields) {
+                std::vector<std::string> row;
+
+                for (const File::View & field : fields) {
+                    row.push_back(field.str());
+                }
+
+                actual.push_back(row);
+            });
+
+            REQUIRE(reader.StatusEndOfFile(status));
+            REQUIRE(actual == expected);
+        }
+
+        unlink(path.c_str());
+    }
+
+    SECTION("It hands out a final row without a trailing newline") {
+        CsvParser parser('\t', '\0');
+        Rows actual;
+        auto collect = [&actual](const std::vector<File::View> & fields) {
+            std::vector<std::string> row;
+
+            for (const File::View & field : fields) {
+                row.push_back(field.str());
+            }
+
+            actual.push_back(row);
+        };
+
+        parser.Feed(std::string("a\t\"b\nc\td"), collect);
+        parser.Finish(collect);
+
+        Rows expected = {{"a", "\"b"}, {"c", "d"}};
+
+        REQUIRE(actual == expected);
+    }
+
+    SECTION("It unquotes fields") {
+        CsvParser parser;
+        std::string scratch;
+
+        REQUIRE(parser.Unquote(File::View("plain"), scratch).str() == "plain");
+        REQUIRE(parser.Unquote(File::View("\"a,b\""), scratch).str() == "a,b");
+        REQUIRE(parser.Unquote(File::View("\"say \"\"hi\"\"\""), scratch).str() == "say \"hi\"");
+    }
+}
@@ -0,0 +1,207 @@
+#include "test_header.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../file.hpp"
+#include "../external_sort.hpp"
+#include "../memory_budget.hpp"
+
+static std::string WriteTemporary(const std::string &contents) {
+    char path[] = "/tmp/file-reader-sort-XXXXXX";
+    int descriptor = mkstemp(path);
+    REQUIRE(descriptor != -1);
+    REQUIRE(write(descriptor, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size()));
+    close(descriptor);
+
+    return path;
+}
+
+static std::string ReadTemporary(const std::string &path) {
+    File::Reader reader;
+    std::string contents;
+
+    REQUIRE(File::StatusOk(reader.Open(path)));
+    REQUIRE(reader.StatusOk(reader.ReadAll(contents)));
+
+    return contents;
+}
+
+// Sort the lines the slow way, to compare against.
+static std::string Expected(std::vector<std::string> lines) {
+    std::sort(lines.begin(), lines.end());
+    std::string expected;
+
+    for (const std::string & line : lines) {
+        expected += line + "\n";
+    }
+
+    return expected;
+}
+
+static std::vector<std::string> MakeLines(size_t count) {
+    std::vector<std::string> lines;
+    unsigned int state = 12345;
+
+    for (size_t i = 0; i < count; i++) {
+        state = state * 1103515245 + 12345;
+
+        // Shared prefixes longer than 8 bytes, duplicates, empty lines and high bytes.
+        std::string line = i % 3 == 0 ? "common-prefix-" : "";
+        size_t size = (state >> 16) % 40;
+
+        for (size_t j = 0; j < size; j++) {
+            state = state * 1103515245 + 12345;
+            line += static_cast<char>(i % 5 == 0 ? 'a' + (state >> 16) % 3 : 1 + (state >> 16) % 254);
+
+            if (line.back() == '\n') {
+                line.back() = '\x80';
+            }
+        }
+
+        lines.push_back(line);
+    }
+
+    return lines;
+}
+
+static std::string Join(const std::vector<std::string> &lines) {
+    std::string contents;
+
+    for (size_t i = 0; i < lines.size(); i++) {
+        contents += lines[i];
+
+        // Leave the last line without a newline.
+        if (i + 1 < lines.size()) {
+            contents += '\n';
+        }
+    }
+
+    return contents;
+}
+
+TEST_CASE("ExternalSorter", "[sort]") {
+    using File::ExternalSorter;
+    using File::Reader;
+
+    char output[] = "/tmp/file-reader-sorted-XXXXXX";
+    int descriptor = mkstemp(output);
+    REQUIRE(descriptor != -1);
+    close(descriptor);
+
+    SECTION("Lines that fit in memory are sorted in a single run") {
+        std::vector<std::string> lines = MakeLines(5000);
+        std::string path = WriteTemporary(Join(lines));
+
+        Reader input;
+        REQUIRE(File::StatusOk(input.Open(path)));
+
+        ExternalSorter sorter(4);
+        Reader::READ_STATUS status = sorter.Sort(input, output);
+
+        unlink(path.c_str());
+
+        REQUIRE(input.StatusEndOfFile(status));
+        REQUIRE(sorter.Runs() == 1);
+        REQUIRE(ReadTemporary(output) == Expected(lines));
+    }
+
+    SECTION("Many runs are merged over several passes") {
+        std::vector<std::string> lines = MakeLines(20000);
+        std::string path = WriteTemporary(Join(lines));
+
+        Reader input;
+        REQUIRE(File::StatusOk(input.Open(path)));
+
+        // 16 KiB runs merged 4 at a time.
+        ExternalSorter sorter(3);
+        sorter.SetMemoryLimit(64 << 10).SetMergeReadSize(8 << 10);
+        Reader::READ_STATUS status = sorter.Sort(input, output);
+
+        unlink(path.c_str());
+
+        REQUIRE(input.StatusEndOfFile(status));
+        REQUIRE(sorter.Runs() > 10);
+        REQUIRE(ReadTemporary(output) == Expected(lines));
+    }
+
+    SECTION("Lines longer than the memory limit still fit") {
+        std::vector<std::string> lines = MakeLines(100);
+        lines[40] = std::string(10000, 'z');
+        lines[41] = std::string(9000, 'y') + "tail";
+        std::string path = WriteTemporary(Join(lines));
+
+        Reader input;
+        REQUIRE(File::StatusOk(input.Open(path)));
+
+        ExternalSorter sorter(2);
+        sorter.SetMemoryLimit(2048).SetMergeReadSize(256);
+        Reader::READ_STATUS status = sorter.Sort(input, output);
+
+        unlink(path.c_str());
+
+        REQUIRE(input.StatusEndOfFile(status));
+        REQUIRE(ReadTemporary(output) == Expected(lines));
+    }
+
+    SECTION("Run buffers and merge blocks count against a shared budget") {
+        std::vector<std::string> lines = MakeLines(20000);
+        std::string path = WriteTemporary(Join(lines));
+
+        Reader input;
+        REQUIRE(File::StatusOk(input.Open(path)));
+
+        File::MemoryBudget budget(64 << 10);
+
+        ExternalSorter sorter(3);
+        sorter.SetMemoryLimit(64 << 10).SetMergeReadSize(8 << 10).SetMemoryBudget(&budget);
+        Reader::READ_STATUS status = sorter.Sort(input, output);
+
+        unlink(path.c_str());
+
+        REQUIRE(input.StatusEndOfFile(status));
+        REQUIRE(ReadTemporary(output) == Expected(lines));
+
+        REQUIRE(budget.InUse() == 0);
+        REQUIRE(budget.Peak() > 0);
+        REQUIRE(budget.Peak() <= (64 << 10));
+    }
+
+    SECTION("Zero sizes fall back to the defaults") {
+        std::vector<std::string> lines = MakeLines(1000);
+        std::string path = WriteTemporary(Join(lines));
+
+        Reader input;
+        REQUIRE(File::StatusOk(input.Open(path)));
+
+        ExternalSorter sorter(2);
+        sorter.SetMemoryLimit(0).SetMergeReadSize(0);
+        Reader::READ_STATUS status = sorter.Sort(input, output);
+
+        unlink(path.c_str());
+
+        REQUIRE(input.StatusEndOfFile(status));
+        REQUIRE(sorter.Runs() == 1);
+        REQUIRE(ReadTemporary(output) == Expected(lines));
+    }
+
+    SECTION("An empty file sorts to an empty file") {
+        std::string path = WriteTemporary("");
+
+        Reader input;
+        REQUIRE(File::StatusOk(input.Open(path)));
+
+        ExternalSorter sorter;
+        Reader::READ_STATUS status = sorter.Sort(input, output);
+
+        unlink(path.c_str());
+
+        REQUIRE(input.StatusEndOfFile(status));
+        REQUIRE(sorter.Runs() == 0);
+        REQUIRE(ReadTemporary(output).empty());
+    }
+
+    unlink(output);
+}
@@ -1,6 +1,7 @@
 #define CATCH_CONFIG_MAIN
 
 #include "test_header.h"
+#include <fcntl.h>
 #include <string>
 #include "../file.hpp"
 
@@ -38,4 +39,37 @@ TEST_CASE("Reader::Open", "[open]") {
         REQUIRE(File::StatusError(status));
         REQUIRE(File::StatusTypeError(status));
     }
+
+    SECTION("It can open files relative to an open directory") {
+        int directory = open("../data", O_RDONLY | O_DIRECTORY);
+        REQUIRE(directory != -1);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.OpenAt(directory, "file")));
+
+        File::STATUS status = reader.OpenAt(directory, std::string("nope"));
+        REQUIRE(File::StatusError(status));
+        REQUIRE(File::StatusAccessError(status));
+
+        close(directory);
+    }
+
+    SECTION("It closes the previous file when opening another one") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        int first = reader.Descriptor();
+        REQUIRE(File::StatusOk(reader.Open("../data/empty")));
+
+        // The old descriptor was released, so it gets handed out again.
+        REQUIRE(reader.Descriptor() == first);
+        REQUIRE(reader.Stat().st_size == 0);
+    }
+
+    SECTION("It leaves regular files in blocking mode") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        REQUIRE((fcntl(reader.Descriptor(), F_GETFL) & O_NONBLOCK) == 0);
+    }
 }
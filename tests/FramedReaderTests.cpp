@@ -0,0 +1,252 @@
+#include "test_header.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <stdlib.h>
+
+#include "../file.hpp"
+#include "../framed_reader.hpp"
+#include "../memory_budget.hpp"
+
+static void AppendVarint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+
+    out += static_cast<char>(value);
+}
+
+static std::string WriteFrames(const std::string &contents) {
+    char path[] = "/tmp/file-reader-frames-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd != -1);
+    REQUIRE(write(fd, contents.data(), contents.size()) == (ssize_t) contents.size());
+    close(fd);
+
+    return path;
+}
+
+static std::vector<std::string> MakeRecords(size_t count) {
+    std::vector<std::string> records;
+
+    for (size_t i = 0; i < count; i++) {
+        // Mostly small records, with the odd one larger than any buffer used below.
+        size_t size = i % 50 == 0 ? 5000 + i : i % 37;
+        records.push_back(std::string(size, static_cast<char>('a' + i % 26)));
+    }
+
+    return records;
+}
+
+TEST_CASE("FramedReader", "[framed]") {
+    using File::FramedReader;
+    using File::Reader;
+
+    std::vector<std::string> records = MakeRecords(300);
+
+    SECTION("It reads varint framed records, growing only for oversized ones") {
+        std::string contents;
+
+        for (const std::string & record : records) {
+            AppendVarint(contents, record.size());
+            contents += record;
+        }
+
+        std::string path = WriteFrames(contents);
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+
+        FramedReader frames(reader, FramedReader::FRAMING::VARINT);
+        frames.SetBufferSize(256);
+
+        std::vector<std::string> actual;
+
+        Reader::READ_STATUS status = frames.Read([&actual](const File::View & record) {
+            actual.push_back(record.str());
+        });
+
+        unlink(path.c_str());
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == records);
+    }
+
+    SECTION("It reads big endian u32 framed records and reports truncation") {
+        std::string contents;
+
+        for (const std::string & record : records) {
+            uint32_t size = record.size();
+            contents += static_cast<char>(size >> 24);
+            contents += static_cast<char>(size >> 16);
+            contents += static_cast<char>(size >> 8);
+            contents += static_cast<char>(size);
+            contents += record;
+        }
+
+        std::string path = WriteFrames(contents.substr(0, contents.size() - 1));
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+
+        FramedReader frames(reader, FramedReader::FRAMING::U32_BIG_ENDIAN);
+        size_t count = 0;
+
+        Reader::READ_STATUS status = frames.Read([&count](const File::View &) {
+            count++;
+        });
+
+        unlink(path.c_str());
+
+        REQUIRE(reader.StatusError(status));
+        REQUIRE(count == records.size() - 1);
+    }
+
+    SECTION("It scans blocks between sync markers in parallel") {
+        const std::string marker = "\x01SYNC-MARKER-16\xfe";
+        std::string contents = "file header";
+
+        for (size_t first = 0; first < records.size(); first += 7) {
+            size_t count = std::min<size_t>(7, records.size() - first);
+
+            contents += marker;
+            AppendVarint(contents, count);
+
+            for (size_t i = first; i < first + count; i++) {
+                AppendVarint(contents, records[i].size());
+                contents += records[i];
+            }
+        }
+
+        std::string path = WriteFrames(contents);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+
+        // Sequentially, the stream has to start with a marker.
+        FramedReader sequential(reader, FramedReader::FRAMING::VARINT);
+        sequential.SetSyncMarker(marker);
+        REQUIRE(reader.StatusError(sequential.Read([](const File::View &) {})));
+
+        for (size_t threads = 1; threads <= 4; threads++) {
+            std::mutex lock;
+            std::vector<std::string> actual;
+            size_t highest_worker = 0;
+
+            Reader::READ_STATUS status = FramedReader::ParallelRead(path, FramedReader::FRAMING::VARINT, marker, threads,
+                [&](size_t worker, const File::View & record) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    actual.push_back(record.str());
+                    highest_worker = std::max(highest_worker, worker);
+                });
+
+            REQUIRE(reader.StatusEndOfFile(status));
+            REQUIRE(highest_worker < threads);
+
+            std::vector<std::string> expected = records;
+            std::sort(expected.begin(), expected.end());
+            std::sort(actual.begin(), actual.end());
+
+            REQUIRE(actual == expected);
+        }
+
+        unlink(path.c_str());
+    }
+
+    SECTION("Blocks spread over many ranges are each read once") {
+        const std::string marker = "\x01SYNC-MARKER-16\xfe";
+        std::vector<std::string> records = MakeRecords(5000);
+        std::string contents;
+
+        for (size_t first = 0; first < records.size(); first += 13) {
+            size_t count = std::min<size_t>(13, records.size() - first);
+
+            contents += marker;
+            AppendVarint(contents, count);
+
+            for (size_t i = first; i < first + count; i++) {
+                AppendVarint(contents, records[i].size());
+                contents += records[i];
+            }
+        }
+
+        std::string path = WriteFrames(contents);
+
+        std::mutex lock;
+        std::vector<std::string> actual;
+
+        Reader::READ_STATUS status = FramedReader::ParallelRead(path, FramedReader::FRAMING::VARINT, marker, 3,
+            [&](size_t, const File::View & record) {
+                std::lock_guard<std::mutex> guard(lock);
+                actual.push_back(record.str());
+            });
+
+        unlink(path.c_str());
+
+        REQUIRE(Reader().StatusEndOfFile(status));
+
+        std::sort(records.begin(), records.end());
+        std::sort(actual.begin(), actual.end());
+
+        REQUIRE(actual == records);
+    }
+
+    SECTION("Many workers reading one large file don't collide") {
+        const std::string marker = "\x01SYNC-MARKER-16\xfe";
+        std::string contents;
+        size_t total = 0;
+
+        // 20000 blocks of 10 records, several MiB, so each of 8 workers gets many ranges.
+        for (size_t block = 0; block < 20000; block++) {
+            contents += marker;
+            AppendVarint(contents, 10);
+
+            for (size_t i = 0; i < 10; i++) {
+                std::string record(1 + (block + i) % 23, static_cast<char>('a' + i));
+                AppendVarint(contents, record.size());
+                contents += record;
+                total++;
+            }
+        }
+
+        REQUIRE(contents.size() > 8 * 4 * (1 << 16));
+
+        std::string path = WriteFrames(contents);
+
+        for (int run = 0; run < 3; run++) {
+            std::atomic<size_t> count(0);
+
+            Reader::READ_STATUS status = FramedReader::ParallelRead(path, FramedReader::FRAMING::VARINT, marker, 8,
+                [&count](size_t, const File::View &) {
+                    count++;
+                });
+
+            REQUIRE(Reader().StatusEndOfFile(status));
+            REQUIRE(count == total);
+        }
+
+        // Records over the limit are corruption, as with SetMaxRecordSize.
+        Reader::READ_STATUS status = FramedReader::ParallelRead(path, FramedReader::FRAMING::VARINT, marker, 8,
+            [](size_t, const File::View &) {}, 20);
+
+        REQUIRE(Reader().StatusError(status));
+
+        // Room for two workers' buffers at a time, the others wait for a range to finish.
+        File::MemoryBudget budget(2 * (1 << 16) + 2 * marker.size());
+        std::atomic<size_t> count(0);
+
+        status = FramedReader::ParallelRead(path, FramedReader::FRAMING::VARINT, marker, 8,
+            [&count](size_t, const File::View &) {
+                count++;
+            }, 0, &budget);
+
+        REQUIRE(File::StatusEndOfFile(status));
+        REQUIRE(count == total);
+        REQUIRE(budget.InUse() == 0);
+        REQUIRE(budget.Peak() > 0);
+        REQUIRE(budget.Peak() <= budget.Limit());
+
+        unlink(path.c_str());
+    }
+}
@@ -0,0 +1,101 @@
+#include "test_header.h"
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#include "../file.hpp"
+#include "../jsonl.hpp"
+
+TEST_CASE("JsonLines", "[jsonl]") {
+    using File::JsonLines;
+    using File::Reader;
+    using File::View;
+
+    SECTION("It validates UTF-8") {
+        REQUIRE(JsonLines::ValidUtf8("plain ascii that is longer than one block", 41));
+        REQUIRE(JsonLines::ValidUtf8("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80", 14));
+        REQUIRE_FALSE(JsonLines::ValidUtf8("overlong \xc0\xaf", 11));
+        REQUIRE_FALSE(JsonLines::ValidUtf8("surrogate \xed\xa0\x80", 13));
+        REQUIRE_FALSE(JsonLines::ValidUtf8("truncated \xe2\x82", 12));
+    }
+
+    SECTION("It checks brackets and strings are balanced") {
+        std::string nested = "{\"a\": [1, {\"b\": \"}]\\\"\"}], \"c\": \"padding padding padding\"}";
+        REQUIRE(JsonLines::Balanced(nested.data(), nested.size()));
+
+        std::string mismatched = "{\"a\": [1, 2}";
+        REQUIRE_FALSE(JsonLines::Balanced(mismatched.data(), mismatched.size()));
+
+        std::string unterminated = "{\"a\": \"b}";
+        REQUIRE_FALSE(JsonLines::Balanced(unterminated.data(), unterminated.size()));
+    }
+
+    SECTION("It extracts top-level values without parsing the rest") {
+        std::string record = "{ \"id\" : 42, \"nested\": {\"id\": 7, \"s\": \"},\"}, \"tags\": [\"a\", \"b\"], \"name\": \"x\\\"y\", \"ok\": true }";
+        View value;
+
+        REQUIRE(JsonLines::Extract(View(record), "id", value));
+        REQUIRE(value.str() == "42");
+
+        REQUIRE(JsonLines::Extract(View(record), "tags", value));
+        REQUIRE(value.str() == "[\"a\", \"b\"]");
+
+        REQUIRE(JsonLines::Extract(View(record), "ok", value));
+        REQUIRE(value.str() == "true");
+
+        REQUIRE_FALSE(JsonLines::Extract(View(record), "s", value));
+
+        std::vector<View> values;
+        REQUIRE(JsonLines::Extract(View(record), {"name", "missing", "nested"}, values) == 2);
+        REQUIRE(values[0].str() == "\"x\\\"y\"");
+        REQUIRE(values[1].empty());
+        REQUIRE(values[2].str() == "{\"id\": 7, \"s\": \"},\"}");
+    }
+
+    SECTION("It splits a file into records, setting invalid ones aside") {
+        std::string contents =
+            "{\"level\": \"info\", \"n\": 1}\n"
+            "\n"
+            "{\"level\": \"error\", \"n\": 2}\r\n"
+            "{\"level\": \"error\", \"n\": [3}\n"
+            "{\"level\": \"bad \xff\", \"n\": 4}\n"
+            "{\"level\": \"error\", \"n\": 5}";
+
+        char path[] = "/tmp/file-reader-jsonl-XXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE(fd != -1);
+        REQUIRE(write(fd, contents.data(), contents.size()) == (ssize_t) contents.size());
+        close(fd);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+        reader.SetReadSize(16);
+
+        JsonLines lines(JsonLines::VALIDATION::UTF8 | JsonLines::VALIDATION::STRUCTURE);
+        std::vector<std::string> errors;
+        int invalid = 0;
+
+        Reader::READ_STATUS status = lines.Parse(reader,
+            [&errors, &contents](off_t offset, const View & record) {
+                REQUIRE(contents.compare(offset, record.size(), record.str()) == 0);
+
+                View level, n;
+
+                if (JsonLines::Extract(record, "level", level) && level == View("\"error\"")) {
+                    REQUIRE(JsonLines::Extract(record, "n", n));
+                    errors.push_back(n.str());
+                }
+            },
+            [&invalid](off_t, const View &) {
+                invalid++;
+            });
+
+        unlink(path);
+
+        std::vector<std::string> expected = {"2", "5"};
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(errors == expected);
+        REQUIRE(invalid == 2);
+    }
+}
@@ -0,0 +1,142 @@
+#include "test_header.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../batch_reader.hpp"
+#include "../file.hpp"
+#include "../lines.hpp"
+#include "../memory_budget.hpp"
+#include "../pipeline.hpp"
+
+TEST_CASE("MemoryBudget", "[budget]") {
+    using File::MemoryBudget;
+    using File::Reader;
+    using File::View;
+
+    SECTION("It tracks reservations and lets oversized ones through alone") {
+        MemoryBudget budget(100);
+
+        REQUIRE(budget.TryReserve(60));
+        REQUIRE(!budget.TryReserve(60));
+        REQUIRE(budget.InUse() == 60);
+
+        budget.Release(60);
+        REQUIRE(budget.TryReserve(500));
+        REQUIRE(budget.Peak() == 500);
+
+        budget.Release(500);
+        REQUIRE(budget.InUse() == 0);
+        REQUIRE(budget.Stalls() == 0);
+    }
+
+    SECTION("Producers block until consumers release, and the stall is counted") {
+        MemoryBudget budget(100);
+        budget.Reserve(80);
+
+        std::atomic<bool> reserved(false);
+
+        std::thread producer([&]() {
+            budget.Reserve(50);
+            reserved = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        bool reserved_early = reserved;
+
+        budget.Release(80);
+        producer.join();
+
+        REQUIRE(!reserved_early);
+        REQUIRE(reserved);
+        REQUIRE(budget.InUse() == 50);
+        REQUIRE(budget.Stalls() == 1);
+        REQUIRE(budget.StalledNanoseconds() > 0);
+    }
+
+    SECTION("Reservations resize, and give back what they hold before growing") {
+        MemoryBudget budget(100);
+
+        {
+            File::MemoryReservation first(&budget, 60);
+            File::MemoryReservation second(&budget);
+
+            REQUIRE(!second.TryResize(50));
+            REQUIRE(second.TryResize(40));
+            REQUIRE(budget.InUse() == 100);
+
+            first.Resize(10);
+            REQUIRE(budget.InUse() == 50);
+
+            // Growing past the limit goes through once the holder is the only one left.
+            File::MemoryReservation moved(std::move(second));
+            first.Resize(0);
+            moved.Resize(150);
+
+            REQUIRE(moved.Bytes() == 150);
+            REQUIRE(budget.InUse() == 150);
+        }
+
+        REQUIRE(budget.InUse() == 0);
+    }
+
+    std::string contents;
+    {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        REQUIRE(reader.StatusOk(reader.ReadAll(contents)));
+    }
+
+    std::vector<std::string> lines;
+    File::LineSplitter splitter;
+    splitter.Feed(contents, [&lines](const View & line) { lines.push_back(line.str()); });
+    splitter.Finish([&lines](const View & line) { lines.push_back(line.str()); });
+
+    SECTION("A budget is shared by batch reads and pipeline stages") {
+        MemoryBudget budget(2000);
+
+        std::vector<std::string> paths(6, "../data/file");
+        std::vector<std::string> actual(paths.size());
+
+        // Reads lock the file, so read the copies one at a time.
+        File::BatchReader batch(1);
+        batch.SetReadSize(500).SetMemoryBudget(&budget);
+
+        batch.Read(paths, [&actual](size_t file, std::string & chunk) {
+            actual[file] += chunk;
+        });
+
+        for (const std::string & file : actual) {
+            REQUIRE(file == contents);
+        }
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        std::atomic<size_t> count(0);
+
+        File::From(reader)
+            | File::Split('\n')
+            | File::Parallel(3, 2, &budget)
+            | File::ForEach([&count](const View &) { count++; });
+
+        REQUIRE(count == lines.size());
+
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        std::vector<std::string> ordered;
+
+        File::From(reader)
+            | File::Split('\n')
+            | File::OrderedMap([](const View & line) { return line.str(); }, 3, 1, 8, &budget)
+            | File::ForEach([&ordered](const std::string & line) { ordered.push_back(line); });
+
+        REQUIRE(ordered == lines);
+
+        REQUIRE(budget.InUse() == 0);
+        REQUIRE(budget.Peak() <= 2000);
+    }
+}
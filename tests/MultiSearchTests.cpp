@@ -0,0 +1,117 @@
+#include "test_header.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <set>
+#include <utility>
+#include <fstream>
+#include <sstream>
+
+#include "../file.hpp"
+#include "../multi_search.hpp"
+
+typedef std::set<std::pair<size_t, off_t>> Matches;
+
+static Matches FindNaive(const std::string &haystack, const std::vector<std::string> &patterns) {
+    Matches matches;
+
+    for (size_t id = 0; id < patterns.size(); id++) {
+        if (patterns[id].empty()) {
+            continue;
+        }
+
+        size_t position = 0;
+
+        while ((position = haystack.find(patterns[id], position)) != std::string::npos) {
+            matches.insert(std::make_pair(id, (off_t) position));
+            position++;
+        }
+    }
+
+    return matches;
+}
+
+static Matches FindStreaming(const char *path, size_t read_size, const File::PatternSet &set) {
+    File::Reader reader;
+    REQUIRE(File::StatusOk(reader.Open(path)));
+    reader.SetReadSize(read_size);
+
+    File::MultiSearcher searcher(set);
+    Matches matches;
+
+    File::Reader::READ_STATUS status = searcher.Search(reader, [&matches](size_t id, off_t offset) {
+        matches.insert(std::make_pair(id, offset));
+    });
+
+    REQUIRE(reader.StatusEndOfFile(status));
+
+    return matches;
+}
+
+TEST_CASE("MultiSearcher", "[search] [multi]") {
+    std::ifstream stream("../data/file");
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    std::string contents = buffer.str();
+
+    SECTION("It matches a small set of overlapping patterns in one pass, across chunks") {
+        std::vector<std::string> patterns = {"commodo", "modo", "do", "", "dolor", "dolore", "zzz"};
+        File::PatternSet set(patterns);
+
+        Matches expected = FindNaive(contents, patterns);
+        REQUIRE_FALSE(expected.empty());
+
+        for (size_t read_size = 1; read_size < 40; read_size += 13) {
+            REQUIRE(FindStreaming("../data/file", read_size, set) == expected);
+        }
+    }
+
+    SECTION("It matches a large set of patterns without a prefilter") {
+        std::vector<std::string> patterns;
+
+        for (size_t i = 0; i + 12 < contents.size(); i += 97) {
+            patterns.push_back(contents.substr(i, 3 + i % 9));
+        }
+
+        REQUIRE(patterns.size() > 8);
+
+        File::PatternSet set(patterns);
+
+        REQUIRE(FindStreaming("../data/file", 4096, set) == FindNaive(contents, patterns));
+    }
+
+    SECTION("It matches binary patterns covering every byte value") {
+        std::vector<std::string> patterns;
+        std::string haystack;
+
+        for (unsigned int byte = 0; byte < 256; byte++) {
+            patterns.push_back(std::string(1, static_cast<char>(byte)) + static_cast<char>(255 - byte));
+        }
+
+        unsigned int state = 7;
+
+        for (size_t i = 0; i < 20000; i++) {
+            state = state * 1103515245 + 12345;
+            haystack += static_cast<char>(state >> 16);
+
+            // Plant whole patterns too, random pairs rarely hit one.
+            if (i % 50 == 0) {
+                haystack += patterns[(state >> 8) % 256];
+            }
+        }
+
+        File::PatternSet set(patterns);
+        File::MultiSearcher searcher(set);
+        Matches actual;
+
+        for (size_t start = 0; start < haystack.size(); start += 1000) {
+            searcher.Feed(haystack.data() + start, std::min<size_t>(1000, haystack.size() - start),
+                [&actual](size_t id, off_t offset) {
+                    actual.insert(std::make_pair(id, offset));
+                });
+        }
+
+        REQUIRE(actual.size() > 400);
+        REQUIRE(actual == FindNaive(haystack, patterns));
+    }
+}
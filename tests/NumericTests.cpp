@@ -0,0 +1,145 @@
+#include "test_header.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <sstream>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "../file.hpp"
+#include "../numeric.hpp"
+
+static std::string WriteNumbers(const std::string &contents) {
+    char path[] = "/tmp/file-reader-numeric-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd != -1);
+    REQUIRE(write(fd, contents.data(), contents.size()) == (ssize_t) contents.size());
+    close(fd);
+
+    return path;
+}
+
+TEST_CASE("ParseInteger", "[numeric]") {
+    using File::View;
+    int64_t value = 0;
+
+    REQUIRE(File::ParseInteger(View("0"), value));
+    REQUIRE(value == 0);
+
+    REQUIRE(File::ParseInteger(View(" -1234567890123 "), value));
+    REQUIRE(value == -1234567890123ll);
+
+    REQUIRE(File::ParseInteger(View("9223372036854775807"), value));
+    REQUIRE(value == INT64_MAX);
+
+    REQUIRE(File::ParseInteger(View("-9223372036854775808"), value));
+    REQUIRE(value == INT64_MIN);
+
+    REQUIRE_FALSE(File::ParseInteger(View("9223372036854775808"), value));
+    REQUIRE_FALSE(File::ParseInteger(View("12a"), value));
+    REQUIRE_FALSE(File::ParseInteger(View("-"), value));
+}
+
+TEST_CASE("ParseDouble", "[numeric]") {
+    using File::View;
+
+    SECTION("It agrees with strtod") {
+        std::vector<std::string> tokens = {
+            "0", "-0.0", "1.5", "3.14159265358979", ".5", "5.", "1e10", "2.5E-3", "0.000123",
+            "123456789012345678", "1.7976931348623157e308", "4.9e-324", "0.1", "1e23", "inf",
+            "12345678.87654321", "9007199254740993",
+        };
+
+        std::mt19937_64 generator(3);
+        std::uniform_real_distribution<double> distribution(-1e6, 1e6);
+
+        for (int i = 0; i < 200; i++) {
+            char text[64];
+            snprintf(text, sizeof(text), "%.*g", 1 + i % 17, distribution(generator));
+            tokens.push_back(text);
+        }
+
+        for (const std::string & token : tokens) {
+            double value = 0;
+
+            INFO(token);
+            REQUIRE(File::ParseDouble(View(token), value));
+            REQUIRE(value == strtod(token.c_str(), nullptr));
+        }
+    }
+
+    SECTION("It rejects malformed numbers") {
+        double value;
+
+        REQUIRE_FALSE(File::ParseDouble(View("."), value));
+        REQUIRE_FALSE(File::ParseDouble(View("1e"), value));
+        REQUIRE_FALSE(File::ParseDouble(View("1.2.3"), value));
+        REQUIRE_FALSE(File::ParseDouble(View("abc"), value));
+    }
+}
+
+TEST_CASE("NumberReader", "[numeric] [reader]") {
+    using File::NumberReader;
+    using File::Reader;
+
+    std::stringstream contents;
+    std::vector<int64_t> expected_integers;
+    std::vector<double> expected_second_column;
+
+    contents << "id,value\n";
+
+    for (int i = 0; i < 500; i++) {
+        int64_t id = (i * 7919ll) - 100000;
+        double value = i * 0.25;
+
+        contents << id << "," << value << "\n";
+        expected_integers.push_back(id);
+        expected_second_column.push_back(value);
+    }
+
+    std::string path = WriteNumbers(contents.str());
+
+    SECTION("It fills caller provided arrays, batch by batch") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+        reader.SetReadSize(13);
+
+        NumberReader numbers(reader);
+        numbers.SetColumn(0);
+
+        std::vector<int64_t> actual;
+        int64_t batch[64];
+        size_t count = 0;
+        Reader::READ_STATUS status;
+
+        do {
+            status = numbers.Read(batch, 64, &count);
+            REQUIRE_FALSE(reader.StatusError(status));
+            actual.insert(actual.end(), batch, batch + count);
+        } while (!reader.StatusEndOfFile(status));
+
+        REQUIRE(actual == expected_integers);
+
+        // The header is the only thing that isn't a number.
+        REQUIRE(numbers.Invalid() == 1);
+    }
+
+    SECTION("It parses a single column as doubles") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+
+        NumberReader numbers(reader);
+        numbers.SetColumn(1);
+
+        std::vector<double> actual(1000);
+        size_t count = 0;
+
+        Reader::READ_STATUS status = numbers.Read(actual.data(), actual.size(), &count);
+        actual.resize(count);
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected_second_column);
+    }
+
+    unlink(path.c_str());
+}
@@ -0,0 +1,97 @@
+#include "test_header.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "../file.hpp"
+#include "../page_buffer.hpp"
+#include "../record_reader.hpp"
+
+TEST_CASE("PageBuffer", "[pages]") {
+    using File::PageBuffer;
+    using File::Reader;
+
+    SECTION("It grows, keeping its contents") {
+        PageBuffer buffer;
+
+        char *data = buffer.Reserve(10);
+        REQUIRE(data != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(data) % 64 == 0);
+        memcpy(data, "0123456789", 10);
+
+        data = buffer.Reserve(1000);
+        REQUIRE(buffer.Capacity() >= 1000);
+        REQUIRE(std::string(data, 10) == "0123456789");
+
+        // Never shrinks.
+        REQUIRE(buffer.Reserve(5) == data);
+    }
+
+    SECTION("Large buffers on huge pages are 2 MiB aligned") {
+        PageBuffer buffer;
+        buffer.SetHugePages(true);
+
+        char *data = buffer.Reserve(100);
+        memcpy(data, "kept", 4);
+
+        data = buffer.Reserve(3 << 20);
+        REQUIRE(data != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(data) % PageBuffer::HUGE_PAGE_SIZE == 0);
+        REQUIRE(buffer.Capacity() % PageBuffer::HUGE_PAGE_SIZE == 0);
+        REQUIRE(std::string(data, 4) == "kept");
+
+        // The whole buffer is writable.
+        memset(data, 'x', buffer.Capacity());
+
+        buffer.Release();
+        REQUIRE(buffer.Data() == nullptr);
+        REQUIRE(buffer.Capacity() == 0);
+    }
+
+    SECTION("Readers and record readers read the same with huge pages") {
+        std::vector<uint32_t> values;
+
+        for (uint32_t i = 0; i < (5 << 20) / sizeof(uint32_t); i++) {
+            values.push_back(i * 2654435761u);
+        }
+
+        char path[] = "/tmp/file-reader-pages-XXXXXX";
+        int descriptor = mkstemp(path);
+        REQUIRE(descriptor != -1);
+
+        const size_t size = values.size() * sizeof(uint32_t);
+        REQUIRE(write(descriptor, values.data(), size) == static_cast<ssize_t>(size));
+        close(descriptor);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+        reader.SetHugePages(true).SetReadSize(4 << 20);
+
+        std::string contents;
+        reader.Read([&contents](std::string & chunk) {
+            contents += chunk;
+        });
+
+        REQUIRE(contents.size() == size);
+        REQUIRE(memcmp(contents.data(), values.data(), size) == 0);
+
+        for (bool mapped : {false, true}) {
+            REQUIRE(File::StatusOk(reader.Open(path)));
+
+            File::RecordReader<uint32_t> records(reader);
+            records.SetBatchSize(1 << 20).SetMapped(mapped).SetHugePages(true);
+
+            std::vector<uint32_t> actual;
+            Reader::READ_STATUS status = records.Read([&actual](File::Span<const uint32_t> batch) {
+                actual.insert(actual.end(), batch.begin(), batch.end());
+            });
+
+            REQUIRE(reader.StatusEndOfFile(status));
+            REQUIRE(actual == values);
+        }
+
+        unlink(path);
+    }
+}
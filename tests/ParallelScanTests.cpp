@@ -0,0 +1,118 @@
+#include "test_header.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../file.hpp"
+#include "../memory_budget.hpp"
+#include "../parallel_scan.hpp"
+
+TEST_CASE("ParallelScanner", "[parallel]") {
+    using File::ParallelScanner;
+    using File::Reader;
+    using File::View;
+
+    // Lines of skewed lengths, with a run of very long ones in the middle.
+    std::vector<std::pair<off_t, std::string>> expected;
+    std::string contents;
+
+    for (size_t i = 0; i < 4000; i++) {
+        size_t length = (i > 1500 && i < 1520) ? 20000 + i : i % 97;
+
+        expected.push_back(std::make_pair(static_cast<off_t>(contents.size()), std::string(length, 'a' + i % 26)));
+        contents += expected.back().second;
+        contents += '\n';
+    }
+
+    // A last line without a newline, and an empty line before it.
+    contents += "\n";
+    expected.push_back(std::make_pair(static_cast<off_t>(contents.size() - 1), std::string()));
+    expected.push_back(std::make_pair(static_cast<off_t>(contents.size()), std::string("last")));
+    contents += "last";
+
+    char path[] = "/tmp/file-reader-scan-XXXXXX";
+    int descriptor = mkstemp(path);
+    REQUIRE(descriptor != -1);
+    REQUIRE(write(descriptor, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size()));
+    close(descriptor);
+
+    Reader reader;
+    REQUIRE(File::StatusOk(reader.Open(path)));
+
+    std::mutex lock;
+    std::vector<std::pair<off_t, std::string>> actual;
+    size_t highest_worker = 0;
+
+    auto collect = [&](size_t worker, off_t offset, const View & record) {
+        std::lock_guard<std::mutex> guard(lock);
+        actual.push_back(std::make_pair(offset, record.str()));
+        highest_worker = std::max(highest_worker, worker);
+    };
+
+    SECTION("Every record is read once from fixed ranges") {
+        // Ranges far smaller than some records, so records straddle several ranges.
+        for (size_t range : {1, 7, 4096, 100000}) {
+            actual.clear();
+
+            ParallelScanner scanner(3);
+            scanner.SetRangeSize(range);
+
+            Reader::READ_STATUS status = scanner.Scan(reader, '\n', collect);
+
+            REQUIRE(reader.StatusEndOfFile(status));
+
+            std::sort(actual.begin(), actual.end());
+            REQUIRE(actual == expected);
+        }
+
+        REQUIRE(highest_worker < 3);
+    }
+
+    SECTION("Every record is read once with adaptive splitting") {
+        ParallelScanner scanner(4);
+        scanner.SetRangeSize(contents.size()).SetAdaptiveSplitting(true, 64);
+
+        Reader::READ_STATUS status = scanner.Scan(reader, '\n', collect);
+
+        REQUIRE(reader.StatusEndOfFile(status));
+
+        std::sort(actual.begin(), actual.end());
+        REQUIRE(actual == expected);
+    }
+
+    SECTION("Every record is read once with pinned workers") {
+        ParallelScanner scanner(2);
+        scanner.SetRangeSize(10000).SetPinWorkers(true);
+
+        Reader::READ_STATUS status = scanner.Scan(reader, '\n', collect);
+
+        REQUIRE(reader.StatusEndOfFile(status));
+
+        std::sort(actual.begin(), actual.end());
+        REQUIRE(actual == expected);
+    }
+
+    SECTION("Workers hold a shared budget while they scan a range") {
+        // Room for one worker's window at a time, the long records are let through alone.
+        File::MemoryBudget budget(1 << 16);
+
+        ParallelScanner scanner(4);
+        scanner.SetRangeSize(4096).SetMemoryBudget(&budget);
+
+        Reader::READ_STATUS status = scanner.Scan(reader, '\n', collect);
+
+        REQUIRE(reader.StatusEndOfFile(status));
+
+        std::sort(actual.begin(), actual.end());
+        REQUIRE(actual == expected);
+
+        REQUIRE(budget.InUse() == 0);
+        REQUIRE(budget.Peak() >= (1 << 16));
+    }
+
+    unlink(path);
+}
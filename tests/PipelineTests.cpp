@@ -0,0 +1,153 @@
+#include "test_header.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "../file.hpp"
+#include "../lines.hpp"
+#include "../pipeline.hpp"
+
+TEST_CASE("Pipeline", "[pipeline]") {
+    using File::Reader;
+    using File::View;
+
+    std::string contents;
+    {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        REQUIRE(reader.StatusOk(reader.ReadAll(contents)));
+    }
+
+    std::vector<std::string> lines;
+    File::LineSplitter splitter;
+    splitter.Feed(contents, [&lines](const View & line) { lines.push_back(line.str()); });
+    splitter.Finish([&lines](const View & line) { lines.push_back(line.str()); });
+
+    Reader reader;
+    REQUIRE(File::StatusOk(reader.Open("../data/file")));
+    reader.SetReadSize(64);
+
+    SECTION("It splits, filters and maps in a single pass") {
+        std::vector<size_t> expected;
+
+        for (const std::string & line : lines) {
+            if (!line.empty()) {
+                expected.push_back(line.size());
+            }
+        }
+
+        std::vector<size_t> actual;
+
+        Reader::READ_STATUS status = File::From(reader)
+            | File::Split('\n')
+            | File::Filter([](const View & line) { return !line.empty(); })
+            | File::Map([](const View & line) { return line.size(); })
+            | File::ForEach([&actual](size_t size) { actual.push_back(size); });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected);
+    }
+
+    SECTION("Records are passed through unchanged without stages") {
+        std::vector<std::string> actual;
+
+        File::From(reader) | File::Split('\n') | File::ForEach([&actual](const View & line) {
+            actual.push_back(line.str());
+        });
+
+        REQUIRE(actual == lines);
+    }
+
+    SECTION("Stages after Parallel run on a pool") {
+        std::atomic<size_t> count(0);
+        std::atomic<size_t> bytes(0);
+
+        File::From(reader)
+            | File::Split('\n')
+            | File::Parallel(4, 3)
+            | File::Map([](const View & line) { return line.size(); })
+            | File::ForEach([&count, &bytes](size_t size) {
+                count++;
+                bytes += size;
+            });
+
+        size_t expected_bytes = 0;
+
+        for (const std::string & line : lines) {
+            expected_bytes += line.size();
+        }
+
+        REQUIRE(count == lines.size());
+        REQUIRE(bytes == expected_bytes);
+    }
+
+    SECTION("A slow batch after Parallel doesn't hold up the others") {
+        std::atomic<bool> first(true);
+        std::atomic<size_t> count(0);
+        bool others_finished = false;
+
+        // One record per batch. The first waits for all the others, which only works if the
+        // reader keeps handing out batches while it's stuck.
+        File::From(reader)
+            | File::Split('\n')
+            | File::Parallel(2, 1)
+            | File::ForEach([&](const View &) {
+                if (first.exchange(false)) {
+                    for (int i = 0; i < 2000 && count < lines.size() - 1; i++) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+
+                    others_finished = count == lines.size() - 1;
+                }
+
+                count++;
+            });
+
+        REQUIRE(count == lines.size());
+        REQUIRE(others_finished);
+    }
+
+    SECTION("OrderedMap keeps the records in order") {
+        std::vector<std::string> expected;
+
+        for (const std::string & line : lines) {
+            expected.push_back(std::to_string(line.size()) + ":" + line);
+        }
+
+        // Small batches and a small reorder buffer, so batches finish out of order and the
+        // reader has to wait for the oldest.
+        std::vector<std::string> actual;
+
+        Reader::READ_STATUS status = File::From(reader)
+            | File::Split('\n')
+            | File::OrderedMap([](const View & line) {
+                return std::to_string(line.size()) + ":" + line.str();
+            }, 4, 2, 3)
+            | File::ForEach([&actual](const std::string & line) { actual.push_back(line); });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected);
+    }
+
+    SECTION("OrderedMap may return views into its records") {
+        std::vector<std::string> expected;
+
+        for (const std::string & line : lines) {
+            expected.push_back(line.substr(0, 3));
+        }
+
+        // The views must outlive the worker's task, until the sink has seen them.
+        std::vector<std::string> actual;
+
+        Reader::READ_STATUS status = File::From(reader)
+            | File::Split('\n')
+            | File::OrderedMap([](const View & line) { return line.substr(0, 3); }, 4, 2, 3)
+            | File::ForEach([&actual](const View & prefix) { actual.push_back(prefix.str()); });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected);
+    }
+}
@@ -0,0 +1,109 @@
+#include "test_header.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../file.hpp"
+#include "../range.hpp"
+#include "../lines.hpp"
+
+TEST_CASE("Range", "[range]") {
+    using File::ChunkRange;
+    using File::LineRange;
+    using File::Reader;
+    using File::View;
+
+    std::string expected;
+    {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        REQUIRE(reader.StatusOk(reader.ReadAll(expected)));
+    }
+
+    SECTION("It iterates the file in chunks of the read size") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        reader.SetReadSize(1000);
+
+        ChunkRange chunks(reader);
+        std::string actual;
+        size_t count = 0;
+
+        for (const View & chunk : chunks) {
+            REQUIRE(chunk.size() <= 1000);
+            actual.append(chunk.data(), chunk.size());
+            count++;
+        }
+
+        REQUIRE(count == 7);
+        REQUIRE(actual == expected);
+        REQUIRE(reader.StatusEndOfFile(chunks.Status()));
+    }
+
+    SECTION("It iterates lines the same way the line splitter does") {
+        std::vector<std::string> split;
+        File::LineSplitter splitter;
+        splitter.Feed(expected, [&split](const View & line) { split.push_back(line.str()); });
+        splitter.Finish([&split](const View & line) { split.push_back(line.str()); });
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        // Smaller than most lines, so lines straddle reads and grow the buffer.
+        reader.SetReadSize(7);
+
+        std::vector<std::string> actual;
+
+        for (const View & line : LineRange(reader)) {
+            actual.push_back(line.str());
+        }
+
+        REQUIRE(actual.size() == 19);
+        REQUIRE(actual == split);
+    }
+
+    SECTION("It works with standard algorithms") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        LineRange lines(reader);
+        long count = std::count_if(lines.begin(), lines.end(), [](const View & line) {
+            return !line.empty();
+        });
+
+        long non_empty = 0;
+        File::LineSplitter splitter;
+        splitter.Feed(expected, [&non_empty](const View & line) { non_empty += !line.empty(); });
+        splitter.Finish([&non_empty](const View & line) { non_empty += !line.empty(); });
+
+        REQUIRE(count == non_empty);
+    }
+
+    SECTION("Empty files and blank lines") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/empty")));
+
+        ChunkRange chunks(reader);
+        REQUIRE(chunks.begin() == chunks.end());
+
+        char path[] = "/tmp/file-reader-range-XXXXXX";
+        int descriptor = mkstemp(path);
+        REQUIRE(descriptor != -1);
+        REQUIRE(write(descriptor, "a\n\nb\n", 5) == 5);
+        close(descriptor);
+
+        REQUIRE(File::StatusOk(reader.Open(path)));
+
+        std::vector<std::string> actual;
+
+        for (const View & line : LineRange(reader)) {
+            actual.push_back(line.str());
+        }
+
+        REQUIRE(actual == std::vector<std::string>({"a", "", "b"}));
+
+        unlink(path);
+    }
+}
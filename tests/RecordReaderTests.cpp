@@ -0,0 +1,156 @@
+#include "test_header.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../file.hpp"
+#include "../record_reader.hpp"
+
+struct Sample
+{
+    uint64_t timestamp;
+    double value;
+    uint32_t sensor;
+};
+
+static std::string WriteRecords(const void *data, size_t size) {
+    char path[] = "/tmp/file-reader-records-XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd != -1);
+    REQUIRE(write(fd, data, size) == (ssize_t) size);
+    close(fd);
+
+    return path;
+}
+
+TEST_CASE("RecordReader", "[records]") {
+    using File::Reader;
+    using File::RecordReader;
+    using File::Span;
+
+    std::vector<Sample> samples;
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        Sample sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.timestamp = 1000000 + i;
+        sample.value = i * 1.5;
+        sample.sensor = i % 7;
+        samples.push_back(sample);
+    }
+
+    // Three stray bytes at the end that don't make a whole record.
+    std::string contents(reinterpret_cast<const char *>(samples.data()), samples.size() * sizeof(Sample));
+    contents += "xyz";
+
+    std::string path = WriteRecords(contents.data(), contents.size());
+
+    for (int mapped = 0; mapped < 2; mapped++) {
+        SECTION(mapped ? "It hands out views into a mapping" : "It hands out batches of whole, aligned records") {
+            Reader reader;
+            REQUIRE(File::StatusOk(reader.Open(path)));
+
+            RecordReader<Sample> records(reader);
+            records.SetBatchSize(64).SetMapped(mapped);
+
+            std::vector<Sample> actual;
+            size_t batches = 0;
+
+            Reader::READ_STATUS status = records.Read([&](Span<const Sample> batch) {
+                REQUIRE(reinterpret_cast<uintptr_t>(batch.data()) % alignof(Sample) == 0);
+                REQUIRE(batch.size() <= 64);
+
+                actual.insert(actual.end(), batch.begin(), batch.end());
+                batches++;
+            });
+
+            REQUIRE(reader.StatusEndOfFile(status));
+            REQUIRE(batches == 16);
+            REQUIRE(records.Trailing() == 3);
+            REQUIRE(actual.size() == samples.size());
+            REQUIRE(memcmp(actual.data(), samples.data(), samples.size() * sizeof(Sample)) == 0);
+        }
+    }
+
+    unlink(path.c_str());
+
+    SECTION("It converts records from the opposite endianness") {
+        std::vector<uint32_t> values;
+
+        for (uint32_t i = 0; i < 101; i++) {
+            values.push_back(__builtin_bswap32(i * 2654435761u));
+        }
+
+        std::string swapped_path = WriteRecords(values.data(), values.size() * sizeof(uint32_t));
+
+        for (int mapped = 0; mapped < 2; mapped++) {
+            Reader reader;
+            REQUIRE(File::StatusOk(reader.Open(swapped_path)));
+
+            RecordReader<uint32_t> records(reader);
+            records.SetBatchSize(10).SetMapped(mapped).SetByteSwap(true);
+
+            std::vector<uint32_t> actual;
+
+            Reader::READ_STATUS status = records.Read([&actual](Span<const uint32_t> batch) {
+                actual.insert(actual.end(), batch.begin(), batch.end());
+            });
+
+            REQUIRE(reader.StatusEndOfFile(status));
+            REQUIRE(actual.size() == values.size());
+
+            for (uint32_t i = 0; i < actual.size(); i++) {
+                REQUIRE(actual[i] == i * 2654435761u);
+            }
+        }
+
+        unlink(swapped_path.c_str());
+    }
+
+    SECTION("It regrows its buffer when the batch size is raised after a read") {
+        std::vector<uint32_t> values;
+
+        for (uint32_t i = 0; i < 5000; i++) {
+            values.push_back(i);
+        }
+
+        std::string values_path = WriteRecords(values.data(), values.size() * sizeof(uint32_t));
+
+        // Copied batches, and swapped batches of a mapping, both fill the batch buffer.
+        for (int mapped = 0; mapped < 2; mapped++) {
+            Reader reader;
+            RecordReader<uint32_t> records(reader);
+            records.SetMapped(mapped).SetByteSwap(mapped);
+
+            for (size_t batch_size = 16; batch_size <= 4096; batch_size *= 16) {
+                REQUIRE(File::StatusOk(reader.Open(values_path)));
+
+                records.SetBatchSize(batch_size);
+
+                std::vector<uint32_t> actual;
+                size_t largest = 0;
+
+                Reader::READ_STATUS status = records.Read([&](Span<const uint32_t> batch) {
+                    actual.insert(actual.end(), batch.begin(), batch.end());
+                    largest = std::max(largest, batch.size());
+                });
+
+                REQUIRE(reader.StatusEndOfFile(status));
+                REQUIRE(largest == batch_size);
+                REQUIRE(actual.size() == values.size());
+
+                bool equal = true;
+
+                for (uint32_t i = 0; i < actual.size(); i++) {
+                    equal = equal && actual[i] == (mapped ? __builtin_bswap32(i) : i);
+                }
+
+                REQUIRE(equal);
+            }
+        }
+
+        unlink(values_path.c_str());
+    }
+}
@@ -0,0 +1,100 @@
+#include "test_header.h"
+#include <string>
+#include <vector>
+#include <regex>
+#include <fstream>
+#include <sstream>
+
+#include "../file.hpp"
+#include "../regex.hpp"
+
+TEST_CASE("Regex::Match", "[regex]") {
+    using File::Regex;
+
+    SECTION("It agrees with std::regex_search") {
+        std::vector<std::string> patterns = {
+            "abc", "^abc", "abc$", "^$", "a.c", "a[bx]c", "[^a-c]+", "\\d{2,3}", "x?y*z+",
+            "(ab|cd)+e", "(?:foo|bar)baz", "^\\s*\\w+=\\d+\\s*$", "a{3}", "a|", "colou?r", "\\.",
+        };
+
+        std::vector<std::string> lines = {
+            "", "abc", "xabc", "abcx", "a-c", "axc", "aaa", "aa", "12", "1234", "z", "yyz",
+            "ababe", "cde", "ae", "foobaz", "barbaz", "fobaz", "  key=42 ", "key=x", "color",
+            "colour", "colouur", "a.b", "ab",
+        };
+
+        for (const std::string & pattern : patterns) {
+            Regex regex(pattern);
+            std::regex expected(pattern);
+
+            REQUIRE(regex.Valid());
+
+            for (const std::string & line : lines) {
+                INFO(pattern << " against " << line);
+                REQUIRE(regex.Match(File::View(line)) == std::regex_search(line, expected));
+            }
+        }
+    }
+
+    SECTION("It rejects malformed patterns") {
+        REQUIRE_FALSE(Regex("(abc").Valid());
+        REQUIRE_FALSE(Regex("abc)").Valid());
+        REQUIRE_FALSE(Regex("[abc").Valid());
+        REQUIRE_FALSE(Regex("*a").Valid());
+        REQUIRE_FALSE(Regex("a{3,1}").Valid());
+
+        // Escaped letters and digits without a meaning here aren't taken as literals.
+        REQUIRE_FALSE(Regex("\\bfoo\\b").Valid());
+        REQUIRE_FALSE(Regex("a\\B").Valid());
+        REQUIRE_FALSE(Regex("(a)\\1").Valid());
+        REQUIRE_FALSE(Regex("[\\q]").Valid());
+        REQUIRE(Regex("\\{\\.\\\\\\-").Valid());
+    }
+
+    SECTION("It extracts a literal required by every match") {
+        REQUIRE(Regex("^\\d+ ERROR: .*timeout").RequiredLiteral() == " ERROR: ");
+        REQUIRE(Regex("(foo)+bar").RequiredLiteral() == "foo");
+        REQUIRE(Regex("foo|bar").RequiredLiteral() == "");
+        REQUIRE(Regex("x?abc").RequiredLiteral() == "abc");
+    }
+}
+
+TEST_CASE("Regex::SearchLines", "[regex] [reader]") {
+    using File::Reader;
+    using File::Regex;
+
+    std::ifstream stream("../data/file");
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    std::string contents = buffer.str();
+
+    std::vector<std::string> patterns = {"commodo\\s+\\w+", "^[A-Z]\\w+ ", "(dolor|amet)\\.$"};
+
+    for (const std::string & pattern : patterns) {
+        std::vector<std::string> expected, actual;
+        std::stringstream lines(contents);
+        std::string line;
+        std::regex reference(pattern);
+
+        while (std::getline(lines, line)) {
+            if (std::regex_search(line, reference)) {
+                expected.push_back(line);
+            }
+        }
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        reader.SetReadSize(100);
+
+        Regex regex(pattern);
+
+        Reader::READ_STATUS status = regex.SearchLines(reader, [&](off_t offset, const File::View & match) {
+            REQUIRE(contents.compare(offset, match.size(), match.str()) == 0);
+            actual.push_back(match.str());
+        });
+
+        INFO(pattern);
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected);
+    }
+}
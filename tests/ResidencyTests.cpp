@@ -0,0 +1,105 @@
+#include "test_header.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../file.hpp"
+
+TEST_CASE("Residency", "[residency]") {
+    using File::Reader;
+
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    const size_t chunk_size = 16 * page_size;
+
+    std::string contents;
+
+    for (size_t i = 0; i < 8 * chunk_size + 100; i++) {
+        contents += static_cast<char>('a' + i % 23);
+    }
+
+    char path[] = "/tmp/file-reader-residency-XXXXXX";
+    int descriptor = mkstemp(path);
+    REQUIRE(descriptor != -1);
+    REQUIRE(write(descriptor, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size()));
+    REQUIRE(fsync(descriptor) == 0);
+
+    Reader reader;
+    REQUIRE(File::StatusOk(reader.Open(path)));
+    reader.SetReadSize(chunk_size);
+
+    SECTION("Freshly written pages are resident") {
+        std::vector<bool> resident;
+
+        REQUIRE(reader.StatusOk(reader.Residency(0, contents.size(), resident)));
+        REQUIRE(resident.size() == (contents.size() + page_size - 1) / page_size);
+        REQUIRE(std::find(resident.begin(), resident.end(), false) == resident.end());
+
+        // An unaligned range covers the pages it touches.
+        REQUIRE(reader.StatusOk(reader.Residency(page_size + 10, page_size, resident)));
+        REQUIRE(resident.size() == 2);
+    }
+
+    SECTION("Every chunk is read once, cached chunks first") {
+        // Drop the first half from the page cache, then pull the second half back in.
+        posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+
+        std::vector<char> buffer(contents.size());
+        ssize_t bytes_read = 0;
+        off_t half = 4 * chunk_size;
+        REQUIRE(reader.StatusOk(reader.ReadAt(buffer.data(), contents.size() - half, half, &bytes_read)));
+
+        std::vector<bool> resident;
+        REQUIRE(reader.StatusOk(reader.Residency(0, half, resident)));
+        bool first_half_cold = std::find(resident.begin(), resident.end(), true) == resident.end();
+
+        std::vector<off_t> offsets;
+        std::string actual(contents.size(), '\0');
+
+        Reader::READ_STATUS status = reader.ReadCachedFirst([&](off_t offset, std::string & chunk) {
+            offsets.push_back(offset);
+            actual.replace(offset, chunk.size(), chunk);
+        });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == contents);
+        REQUIRE(offsets.size() == 9);
+
+        std::vector<off_t> sorted = offsets;
+        std::sort(sorted.begin(), sorted.end());
+        REQUIRE(std::unique(sorted.begin(), sorted.end()) == sorted.end());
+
+        // Only meaningful where the kernel honoured DONTNEED.
+        if (first_half_cold) {
+            for (size_t i = 0; i < 5; i++) {
+                REQUIRE(offsets[i] >= half);
+            }
+        }
+    }
+
+    SECTION("A cold file with more chunks than the lookahead is read once, in windows") {
+        // One page chunks, 129 of them, twice as many as are fetched ahead at once.
+        reader.SetReadSize(page_size);
+        posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+
+        std::vector<off_t> offsets;
+        std::string actual(contents.size(), '\0');
+
+        Reader::READ_STATUS status = reader.ReadCachedFirst([&](off_t offset, std::string & chunk) {
+            offsets.push_back(offset);
+            actual.replace(offset, chunk.size(), chunk);
+        });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == contents);
+        REQUIRE(offsets.size() == (contents.size() + page_size - 1) / page_size);
+
+        std::sort(offsets.begin(), offsets.end());
+        REQUIRE(std::unique(offsets.begin(), offsets.end()) == offsets.end());
+    }
+
+    close(descriptor);
+    unlink(path);
+}
@@ -0,0 +1,148 @@
+#include "test_header.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "../file.hpp"
+
+static std::vector<std::string> SplitLines(const std::string &contents) {
+    std::vector<std::string> lines;
+    std::stringstream stream(contents);
+    std::string line;
+
+    while (std::getline(stream, line)) {
+        lines.push_back(line);
+    }
+
+    return lines;
+}
+
+TEST_CASE("Reader::ReadReverse", "[reader] [reverse]") {
+    using File::Reader;
+
+    std::ifstream stream("../data/file");
+    REQUIRE(stream.good());
+
+    std::stringstream expected_stream;
+    expected_stream << stream.rdbuf();
+    std::string expected = expected_stream.str();
+
+    SECTION("It reads chunks from the end of the file to the beginning") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        std::vector<std::string> chunks;
+
+        Reader::READ_STATUS status = reader.SetReadSize(100).ReadReverse([&chunks](std::string & chunk) {
+            chunks.push_back(chunk);
+        });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+
+        // Every chunk but the first one read is a full, aligned chunk.
+        for (size_t i = 1; i < chunks.size(); i++) {
+            REQUIRE(chunks[i].size() == 100);
+        }
+
+        std::string actual;
+        std::reverse(chunks.begin(), chunks.end());
+
+        for (auto &chunk : chunks) {
+            actual += chunk;
+        }
+
+        REQUIRE(actual == expected);
+    }
+
+    SECTION("It reads lines from last to first") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        std::vector<std::string> lines;
+
+        Reader::READ_STATUS status = reader.SetReadSize(16).ReadLinesReverse([&lines](const File::View & line) {
+            lines.push_back(line.str());
+
+            return true;
+        });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+
+        std::vector<std::string> expected_lines = SplitLines(expected);
+        std::reverse(lines.begin(), lines.end());
+
+        REQUIRE(lines == expected_lines);
+    }
+
+    SECTION("It reads lines many chunks long") {
+        std::string contents = std::string(5000, 'a') + "\nshort\n\n" + std::string(10000, 'b') + "\nc\n"
+            + std::string(3000, 'd');
+
+        char path[] = "/tmp/file-reader-reverse-XXXXXX";
+        int descriptor = mkstemp(path);
+        REQUIRE(descriptor != -1);
+        REQUIRE(write(descriptor, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size()));
+        close(descriptor);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(path)));
+
+        std::vector<std::string> lines;
+
+        Reader::READ_STATUS status = reader.SetReadSize(16).ReadLinesReverse([&lines](const File::View & line) {
+            lines.push_back(line.str());
+
+            return true;
+        });
+
+        unlink(path);
+
+        REQUIRE(reader.StatusEndOfFile(status));
+
+        std::reverse(lines.begin(), lines.end());
+
+        REQUIRE(lines == SplitLines(contents));
+    }
+
+    SECTION("It stops once the callback returns false") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        std::vector<std::string> lines;
+
+        Reader::READ_STATUS status = reader.ReadLinesReverse([&lines](const File::View & line) {
+            lines.push_back(line.str());
+
+            return lines.size() < 3;
+        });
+
+        REQUIRE(reader.StatusOk(status));
+        REQUIRE_FALSE(reader.StatusEndOfFile(status));
+
+        std::vector<std::string> expected_lines = SplitLines(expected);
+
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[0] == expected_lines[expected_lines.size() - 1]);
+        REQUIRE(lines[2] == expected_lines[expected_lines.size() - 3]);
+    }
+
+    SECTION("It doesn't produce any lines for an empty file") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/empty")));
+
+        int count = 0;
+
+        Reader::READ_STATUS status = reader.ReadLinesReverse([&count](const File::View &) {
+            count++;
+
+            return true;
+        });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(count == 0);
+    }
+}
@@ -0,0 +1,140 @@
+#include "test_header.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <random>
+
+#include "../file.hpp"
+#include "../lines.hpp"
+#include "../search.hpp"
+
+static std::string ReadFixture(const char *path) {
+    std::ifstream stream(path);
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+
+    return buffer.str();
+}
+
+static std::vector<size_t> FindAll(const std::string &haystack, const std::string &pattern) {
+    std::vector<size_t> positions;
+    size_t position = 0;
+
+    while ((position = haystack.find(pattern, position)) != std::string::npos) {
+        positions.push_back(position);
+        position++;
+    }
+
+    return positions;
+}
+
+TEST_CASE("LineSplitter", "[lines]") {
+    using File::LineSplitter;
+
+    SECTION("It carries partial lines across chunks") {
+        LineSplitter splitter;
+        std::vector<std::string> lines;
+        auto collect = [&lines](const File::View & line) {
+            lines.push_back(line.str());
+        };
+
+        splitter.Feed(std::string("one\ntw"), collect);
+        splitter.Feed(std::string("o"), collect);
+        splitter.Feed(std::string("\nthree\n\nfour"), collect);
+        splitter.Finish(collect);
+
+        std::vector<std::string> expected = {"one", "two", "three", "", "four"};
+
+        REQUIRE(lines == expected);
+    }
+}
+
+TEST_CASE("Searcher::Find", "[search]") {
+    using File::Searcher;
+
+    SECTION("It finds the same positions as std::string::find") {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<int> letter('a', 'c');
+
+        std::string haystack;
+
+        for (int i = 0; i < 4096; i++) {
+            haystack += static_cast<char>(letter(generator));
+        }
+
+        for (size_t length = 1; length <= 40; length += 3) {
+            std::string pattern = haystack.substr(length * 50, length);
+            Searcher searcher(pattern);
+
+            std::vector<size_t> actual;
+            size_t position = 0;
+
+            while ((position = searcher.Find(haystack.data(), haystack.size(), position)) != File::View::npos) {
+                actual.push_back(position);
+                position++;
+            }
+
+            REQUIRE(actual == FindAll(haystack, pattern));
+        }
+    }
+
+    SECTION("It never matches an empty pattern or a pattern longer than the haystack") {
+        Searcher empty("");
+        Searcher longer("abcdef");
+
+        REQUIRE(empty.Find(File::View("abc")) == File::View::npos);
+        REQUIRE(longer.Find(File::View("abc")) == File::View::npos);
+    }
+}
+
+TEST_CASE("Searcher::Search", "[search] [reader]") {
+    using File::Reader;
+    using File::Searcher;
+
+    std::string contents = ReadFixture("../data/file");
+
+    SECTION("It reports matches straddling chunk boundaries") {
+        for (size_t read_size = 1; read_size < 24; read_size += 5) {
+            Reader reader;
+            REQUIRE(File::StatusOk(reader.Open("../data/file")));
+            reader.SetReadSize(read_size);
+
+            Searcher searcher("commodo");
+            std::vector<size_t> actual;
+
+            Reader::READ_STATUS status = searcher.Search(reader, [&actual](off_t offset) {
+                actual.push_back(offset);
+            });
+
+            REQUIRE(reader.StatusEndOfFile(status));
+            REQUIRE_FALSE(actual.empty());
+            REQUIRE(actual == FindAll(contents, "commodo"));
+        }
+    }
+
+    SECTION("It reports matching lines with their offsets") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+        reader.SetReadSize(64);
+
+        Searcher searcher("commodo");
+        std::vector<std::string> expected, actual;
+        std::stringstream stream(contents);
+        std::string line;
+
+        while (std::getline(stream, line)) {
+            if (line.find("commodo") != std::string::npos) {
+                expected.push_back(line);
+            }
+        }
+
+        Reader::READ_STATUS status = searcher.SearchLines(reader, [&](off_t offset, const File::View & match) {
+            REQUIRE(contents.compare(offset, match.size(), match.str()) == 0);
+            actual.push_back(match.str());
+        });
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected);
+    }
+}
@@ -0,0 +1,96 @@
+#include "test_header.h"
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../file.hpp"
+
+TEST_CASE("Reader::ReadSparse", "[reader] [sparse]") {
+    using File::Reader;
+
+    SECTION("It reads data regions and reports holes without materializing them") {
+        char file_path[] = "/tmp/file-reader-sparse-XXXXXX";
+        int fd = mkstemp(file_path);
+        REQUIRE(fd != -1);
+
+        const off_t hole_size = 1 << 20;
+        std::string head = "head of the file";
+        std::string tail = "tail of the file";
+
+        REQUIRE(pwrite(fd, head.data(), head.size(), 0) == (ssize_t) head.size());
+        REQUIRE(pwrite(fd, tail.data(), tail.size(), hole_size) == (ssize_t) tail.size());
+
+        // Where the filesystem says the head's data region ends, if it tracks holes at all.
+        off_t data_end = lseek(fd, 0, SEEK_HOLE);
+        bool has_holes = data_end != -1 && data_end < hole_size;
+        close(fd);
+
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open(file_path)));
+
+        std::string expected(hole_size + tail.size(), '\0');
+        expected.replace(0, head.size(), head);
+        expected.replace(hole_size, tail.size(), tail);
+
+        std::string actual;
+        std::vector<std::pair<off_t, off_t>> chunks;
+        std::vector<std::pair<off_t, off_t>> holes;
+
+        Reader::READ_STATUS status = reader.SetReadSize(7).ReadSparse(
+            [&actual, &chunks](off_t offset, std::string & chunk) {
+                chunks.push_back(std::make_pair(offset, (off_t) chunk.size()));
+                actual.resize(offset, '\0');
+                actual += chunk;
+            },
+            [&actual, &holes](off_t offset, off_t length) {
+                REQUIRE(offset == (off_t) actual.size());
+                holes.push_back(std::make_pair(offset, length));
+                actual.append(length, '\0');
+            });
+
+        unlink(file_path);
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected);
+
+        if (has_holes) {
+            REQUIRE(holes.size() == 1);
+            REQUIRE(holes[0].first == data_end);
+            REQUIRE(holes[0].second == hole_size - data_end);
+
+            // No data chunk reaches into the hole.
+            bool overlaps = false;
+
+            for (const std::pair<off_t, off_t> & chunk : chunks) {
+                overlaps = overlaps || (chunk.first < hole_size && chunk.first + chunk.second > data_end);
+            }
+
+            REQUIRE_FALSE(overlaps);
+        }
+    }
+
+    SECTION("It reads a dense file as a single data region") {
+        Reader reader;
+        REQUIRE(File::StatusOk(reader.Open("../data/file")));
+
+        std::string actual, expected;
+        reader.ReadAll(expected);
+
+        Reader sparse_reader;
+        REQUIRE(File::StatusOk(sparse_reader.Open("../data/file")));
+
+        Reader::READ_STATUS status = sparse_reader.ReadSparse(
+            [&actual](off_t offset, std::string & chunk) {
+                REQUIRE(offset == (off_t) actual.size());
+                actual += chunk;
+            },
+            [](off_t, off_t) {
+                FAIL("A dense file has no holes");
+            });
+
+        REQUIRE(sparse_reader.StatusEndOfFile(status));
+        REQUIRE(actual == expected);
+    }
+}
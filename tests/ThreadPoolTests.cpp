@@ -0,0 +1,70 @@
+#include "test_header.h"
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "../thread_pool.hpp"
+
+TEST_CASE("ThreadPool", "[pool]") {
+    using File::ThreadPool;
+
+    SECTION("It runs every task before Wait returns") {
+        ThreadPool pool(4);
+        std::atomic<int> count(0);
+
+        for (int i = 0; i < 1000; i++) {
+            pool.Submit([&count]() { count++; });
+        }
+
+        pool.Wait();
+        REQUIRE(count == 1000);
+    }
+
+    SECTION("Tasks can submit more tasks") {
+        ThreadPool pool(4);
+        std::atomic<int> count(0);
+
+        // A binary tree of tasks, all spawned from inside the pool.
+        std::function<void(int)> spawn = [&pool, &count, &spawn](int depth) {
+            count++;
+
+            if (depth > 0) {
+                pool.Submit([&spawn, depth]() { spawn(depth - 1); });
+                pool.Submit([&spawn, depth]() { spawn(depth - 1); });
+            }
+        };
+
+        pool.Submit([&spawn]() { spawn(10); });
+        pool.Wait();
+
+        REQUIRE(count == 2047);
+    }
+
+    SECTION("Idle workers steal from a busy one") {
+        ThreadPool pool(4);
+        std::mutex lock;
+        std::set<std::thread::id> threads;
+        std::set<size_t> indexes;
+
+        // Everything is queued on one worker, the others can only get work by stealing.
+        pool.Submit([&]() {
+            for (int i = 0; i < 64; i++) {
+                pool.Submit([&]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+                    std::lock_guard<std::mutex> guard(lock);
+                    threads.insert(std::this_thread::get_id());
+                    indexes.insert(pool.WorkerIndex());
+                });
+            }
+        });
+
+        pool.Wait();
+
+        REQUIRE(threads.size() > 1);
+        REQUIRE(*indexes.rbegin() < pool.Size());
+        REQUIRE(pool.WorkerIndex() == pool.Size());
+    }
+}
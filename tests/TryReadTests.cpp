@@ -0,0 +1,142 @@
+#include "test_header.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../file.hpp"
+
+TEST_CASE("TryRead", "[try-read]") {
+    using File::Reader;
+
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+
+    std::string contents;
+
+    for (size_t i = 0; i < 8 * page_size + 100; i++) {
+        contents += static_cast<char>('a' + i % 19);
+    }
+
+    char path[] = "/tmp/file-reader-try-read-XXXXXX";
+    int descriptor = mkstemp(path);
+    REQUIRE(descriptor != -1);
+    REQUIRE(write(descriptor, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size()));
+    REQUIRE(fsync(descriptor) == 0);
+
+    Reader reader;
+    REQUIRE(File::StatusOk(reader.Open(path)));
+    reader.SetReadSize(page_size);
+
+    SECTION("Cached data is read without blocking, or not at all") {
+        std::string actual;
+        std::string chunk;
+        Reader::READ_STATUS status;
+        bool would_block = false;
+
+        do {
+            status = reader.TryRead(chunk);
+
+            // Some filesystems can't read without blocking, finish those the usual way.
+            if (reader.StatusWouldBlock(status)) {
+                REQUIRE(chunk.empty());
+                would_block = true;
+                status = reader.Read(chunk);
+            }
+
+            REQUIRE(chunk.size() <= page_size);
+            actual += chunk;
+        } while (reader.StatusOk(status) && !reader.StatusEndOfFile(status));
+
+        REQUIRE(reader.StatusEndOfFile(status));
+        REQUIRE(actual == contents);
+
+        std::vector<bool> resident;
+        REQUIRE(reader.StatusOk(reader.Residency(0, contents.size(), resident)));
+
+        if (std::find(resident.begin(), resident.end(), false) == resident.end() && !would_block) {
+            // Every read completed right away, and the last one hit the end of the file.
+            REQUIRE(reader.StatusEndOfFile(reader.TryRead(chunk)));
+            REQUIRE(chunk.empty());
+        }
+    }
+
+    SECTION("Reads at an offset stop at the end of the file") {
+        std::vector<char> buffer(page_size);
+        ssize_t bytes_read = 0;
+        off_t offset = contents.size() - 50;
+
+        Reader::READ_STATUS status = reader.TryReadAt(buffer.data(), buffer.size(), offset, &bytes_read);
+
+        if (!reader.StatusWouldBlock(status)) {
+            REQUIRE(reader.StatusEndOfFile(status));
+            REQUIRE(bytes_read == 50);
+            REQUIRE(std::string(buffer.data(), bytes_read) == contents.substr(offset));
+        }
+    }
+
+    SECTION("With non-blocking reads disabled every try would block") {
+        reader.SetNonBlockingReads(false);
+
+        std::string chunk;
+        REQUIRE(reader.StatusWouldBlock(reader.TryRead(chunk)));
+        REQUIRE(chunk.empty());
+
+        std::vector<char> buffer(page_size);
+        ssize_t bytes_read = 1;
+        REQUIRE(reader.StatusWouldBlock(reader.TryReadAt(buffer.data(), buffer.size(), 0, &bytes_read)));
+        REQUIRE(bytes_read == 0);
+
+        // Nothing was consumed, a blocking read starts at the beginning.
+        REQUIRE(reader.StatusOk(reader.Read(chunk)));
+        REQUIRE(chunk == contents.substr(0, page_size));
+
+        reader.SetNonBlockingReads(true);
+        Reader::READ_STATUS status = reader.TryRead(chunk);
+
+        REQUIRE_FALSE(reader.StatusError(status));
+
+        if (!reader.StatusWouldBlock(status)) {
+            REQUIRE(chunk == contents.substr(page_size, chunk.size()));
+        }
+    }
+
+    SECTION("Pages dropped from the cache would block") {
+        std::vector<char> buffer(page_size);
+        ssize_t bytes_read = 0;
+        bool would_block = false;
+
+        // Whether the page actually leaves the cache is up to the kernel: tmpfs keeps it, and
+        // mincore can report it gone while a read still finds it. Give it a few tries, letting
+        // readahead started by the previous one settle first.
+        for (int attempt = 0; attempt < 5 && !would_block; attempt++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+
+            Reader::READ_STATUS status = reader.TryReadAt(buffer.data(), buffer.size(), 0, &bytes_read);
+            REQUIRE_FALSE(reader.StatusError(status));
+
+            would_block = reader.StatusWouldBlock(status);
+
+            if (would_block) {
+                REQUIRE(bytes_read == 0);
+            } else {
+                REQUIRE(std::string(buffer.data(), bytes_read) == contents.substr(0, bytes_read));
+            }
+        }
+
+        if (!would_block) {
+            WARN("The page stayed cached, a read that would block on the disk wasn't seen");
+        }
+
+        // A blocking read still gets the data.
+        REQUIRE(reader.StatusOk(reader.ReadAt(buffer.data(), buffer.size(), 0, &bytes_read)));
+        REQUIRE(std::string(buffer.data(), bytes_read) == contents.substr(0, page_size));
+    }
+
+    close(descriptor);
+    unlink(path);
+}
@@ -0,0 +1,208 @@
+#include "thread_pool.hpp"
+#include "affinity.hpp"
+#include "allocator.hpp"
+
+#include <chrono>
+
+namespace File {
+
+namespace {
+
+// How long a worker waits for a task before handing its cached buffers back.
+const std::chrono::milliseconds IDLE_TRIM_DELAY(200);
+
+// The pool and index of the worker running on this thread, if any.
+thread_local const ThreadPool *current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+} // End anonymous namespace
+
+ThreadPool::ThreadPool(size_t threads, bool pin_workers) :
+    queued(0),
+    pending(0),
+    next_queue(0),
+    stopping(false)
+{
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    std::vector<int> cpus;
+
+    if (pin_workers) {
+        cpus = CpusByNode();
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        queues.emplace_back(new Queue());
+
+        worker_cpus.push_back(cpus.empty() ? -1 : cpus[i % cpus.size()]);
+        worker_nodes.push_back(cpus.empty() ? 0 : CpuNode(worker_cpus.back()));
+    }
+
+    // Steal from the workers after this one, those on the same node first.
+    for (size_t i = 0; i < threads; i++) {
+        std::vector<size_t> order;
+
+        for (size_t pass = 0; pass < 2; pass++) {
+            for (size_t j = 1; j < threads; j++) {
+                size_t victim = (i + j) % threads;
+
+                if ((worker_nodes[victim] == worker_nodes[i]) == (pass == 0)) {
+                    order.push_back(victim);
+                }
+            }
+        }
+
+        steal_order.push_back(order);
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::Work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    Wait();
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+
+    task_available.notify_all();
+
+    for (std::thread & worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    size_t index = WorkerIndex();
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (index == queues.size()) {
+            index = next_queue++ % queues.size();
+        }
+
+        // Counted in the same critical section it becomes visible in, a worker that takes
+        // it can only count it off afterwards.
+        {
+            std::lock_guard<std::mutex> queue_guard(queues[index]->lock);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+
+        pending++;
+        queued++;
+    }
+
+    task_available.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock<std::mutex> guard(lock);
+
+    idle.wait(guard, [this]() {
+        return pending == 0;
+    });
+}
+
+size_t ThreadPool::Size() const {
+    return workers.size();
+}
+
+size_t ThreadPool::WorkerIndex() const {
+    return current_pool == this ? current_index : queues.size();
+}
+
+int ThreadPool::WorkerNode() const {
+    return current_pool == this ? worker_nodes[current_index] : -1;
+}
+
+bool ThreadPool::Take(size_t index, std::function<void()> & task) {
+    {
+        Queue &own = *queues[index];
+        std::lock_guard<std::mutex> guard(own.lock);
+
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t other : steal_order[index]) {
+        Queue &victim = *queues[other];
+        std::lock_guard<std::mutex> guard(victim.lock);
+
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::Work(size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    // Pin before the first task, so everything the worker allocates and touches is placed
+    // on its node.
+    if (worker_cpus[index] != -1) {
+        PinCurrentThread(worker_cpus[index]);
+    }
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+
+            auto ready = [this]() {
+                return stopping || queued > 0;
+            };
+
+            // Buffers cached by an idle worker would otherwise be held for the pool's life.
+            if (!task_available.wait_for(guard, IDLE_TRIM_DELAY, ready)) {
+                guard.unlock();
+                BufferAllocator::Trim();
+                guard.lock();
+
+                task_available.wait(guard, ready);
+            }
+
+            if (queued == 0) {
+                return;
+            }
+        }
+
+        std::function<void()> task;
+
+        // Another worker may have taken the task we were woken for.
+        if (!Take(index, task)) {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queued--;
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (--pending == 0) {
+            idle.notify_all();
+        }
+    }
+}
+
+} // End File
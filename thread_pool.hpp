@@ -0,0 +1,81 @@
+#ifndef FILE_THREAD_POOL_H
+#define FILE_THREAD_POOL_H
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace File
+{
+
+// A fixed set of worker threads running submitted tasks.
+//
+// Every worker has its own deque. Tasks submitted from outside the pool are dealt out
+// round robin, tasks submitted by a worker go on its own deque and are run newest first
+// while they're still cache warm. A worker with nothing left steals the oldest task of
+// another, so uneven tasks don't leave workers idle.
+//
+// Workers can be pinned to CPUs, filling one NUMA node before the next. Pinned workers
+// steal from workers on their own node first, so a task's data stays node local.
+class ThreadPool
+{
+public:
+  // Zero threads means one per hardware thread.
+  explicit ThreadPool(size_t threads = 0, bool pin_workers = false);
+
+  // Finishes every submitted task before joining the workers.
+  ~ThreadPool();
+
+  void Submit(std::function<void()> task);
+
+  // Block until every task submitted so far has finished. Must not be called from a task.
+  void Wait();
+
+  size_t Size() const;
+
+  // The calling worker's index in this pool, or Size() if it isn't one of its workers.
+  size_t WorkerIndex() const;
+
+  // The NUMA node the calling worker is pinned to, 0 if it isn't pinned, -1 if it isn't one
+  // of this pool's workers.
+  int WorkerNode() const;
+
+private:
+  struct Queue
+  {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<Queue>> queues;
+
+  // Per worker, the CPU it's pinned to (-1 if not), its node and the order it steals in.
+  std::vector<int> worker_cpus;
+  std::vector<int> worker_nodes;
+  std::vector<std::vector<size_t>> steal_order;
+
+  std::mutex lock;
+  std::condition_variable task_available;
+  std::condition_variable idle;
+
+  // Tasks queued, and tasks queued or running.
+  size_t queued;
+  size_t pending;
+  size_t next_queue;
+  bool stopping;
+
+  void Work(size_t index);
+
+  // Pop from the worker's own deque, or steal from another.
+  bool Take(size_t index, std::function<void()> &task);
+};
+
+} // End File
+
+#endif // FILE_THREAD_POOL_H
@@ -0,0 +1,81 @@
+#ifndef FILE_VIEW_H
+#define FILE_VIEW_H
+
+#include <string.h>
+#include <string>
+
+namespace File
+{
+
+// A non-owning view over a range of bytes, usually pointing into a reader's buffer.
+// Views are only valid until the buffer they point into is reused.
+class View
+{
+public:
+  enum : size_t { npos = static_cast<size_t>(-1) };
+
+  View() : pointer(nullptr), length(0) {}
+  View(const char *data, size_t size) : pointer(data), length(size) {}
+  View(const std::string &string) : pointer(string.data()), length(string.size()) {}
+
+  const char *data() const { return pointer; }
+  size_t size() const { return length; }
+  bool empty() const { return length == 0; }
+
+  const char *begin() const { return pointer; }
+  const char *end() const { return pointer + length; }
+
+  char operator[](size_t index) const { return pointer[index]; }
+
+  View substr(size_t position, size_t count = npos) const
+  {
+    if (position > length) {
+      position = length;
+    }
+
+    if (count > length - position) {
+      count = length - position;
+    }
+
+    return View(pointer + position, count);
+  }
+
+  std::string str() const { return std::string(pointer, length); }
+
+  bool operator==(const View &other) const
+  {
+    return length == other.length && (length == 0 || memcmp(pointer, other.pointer, length) == 0);
+  }
+
+  bool operator!=(const View &other) const { return !(*this == other); }
+
+private:
+  const char *pointer;
+  size_t length;
+};
+
+// A non-owning view over a contiguous array of T.
+template <typename T>
+class Span
+{
+public:
+  Span() : pointer(nullptr), length(0) {}
+  Span(T *data, size_t size) : pointer(data), length(size) {}
+
+  T *data() const { return pointer; }
+  size_t size() const { return length; }
+  bool empty() const { return length == 0; }
+
+  T *begin() const { return pointer; }
+  T *end() const { return pointer + length; }
+
+  T &operator[](size_t index) const { return pointer[index]; }
+
+private:
+  T *pointer;
+  size_t length;
+};
+
+} // End File
+
+#endif // FILE_VIEW_H